@@ -0,0 +1,483 @@
+#include "ofMain.h"
+#include "SpatialIndex.h"
+#include "SelectionSet.h"
+#include "BaseElement.h"
+#include "ImageElement.h"
+#include "ColorRemap.h"
+#include "SwatchExtractor.h"
+#include "RegionSet.h"
+#include <chrono>
+
+// Headless benchmark for the tile pipeline's CPU hot paths.
+// Run from bench/ with `make && make run`.
+//
+//   bin/bench [tiles] [--json]
+//
+// --json prints one JSON document instead of the table, for comparing runs.
+// The exit code is non-zero when a fast path disagrees with its reference.
+
+static const int TILE_SIZE = BaseElement::TILE_SIZE;
+
+struct Result {
+    string group;
+    string name;
+    double microsPerOp;
+    size_t operations;
+};
+
+static vector<Result> results;
+static string currentGroup;
+static bool jsonOutput = false;
+static int mismatches = 0;
+
+static void beginGroup(const string& name) {
+    currentGroup = name;
+    if(!jsonOutput) cout << "-- " << name << endl;
+}
+
+static void check(bool ok, const string& what) {
+    if(!ok) {
+        mismatches++;
+        if(!jsonOutput) cout << "MISMATCH: " << what << endl;
+    }
+}
+
+struct Timer {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    double micros() const {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+static void report(const string& name, double totalMicros, size_t operations) {
+    results.push_back({currentGroup, name, totalMicros / operations, operations});
+    if(jsonOutput) return;
+    cout << ofToString(name, 28, ' ') << ofToString(totalMicros / operations, 3) << " us/op"
+         << "  (" << operations << " ops)" << endl;
+}
+
+// Tiles on a loose grid with some jitter, as after manual alignment
+static vector<ofRectangle> makeTiles(size_t count, float canvasWidth) {
+    vector<ofRectangle> tiles;
+    tiles.reserve(count);
+    int columns = canvasWidth / TILE_SIZE;
+    for(size_t i = 0; i < count; i++) {
+        float x = (i % columns) * TILE_SIZE + ofRandom(-10, 10);
+        float y = (i / columns) * TILE_SIZE + ofRandom(-10, 10);
+        tiles.emplace_back(x, y, TILE_SIZE, TILE_SIZE);
+    }
+    return tiles;
+}
+
+// The previous hit test: reverse linear scan
+static int linearPoint(const vector<ofRectangle>& tiles, float x, float y) {
+    for(int i = tiles.size() - 1; i >= 0; i--) {
+        const auto& r = tiles[i];
+        if(x >= r.x && x < r.x + r.width && y >= r.y && y < r.y + r.height) return i;
+    }
+    return -1;
+}
+
+static void linearRect(const vector<ofRectangle>& tiles, const ofRectangle& rect, vector<int>& result) {
+    result.clear();
+    for(size_t i = 0; i < tiles.size(); i++) {
+        if(tiles[i].intersects(rect)) result.push_back(i);
+    }
+}
+
+static void benchSpatialIndex(size_t numTiles) {
+    ofSeedRandom(1);
+    float canvasWidth = 16000;
+    vector<ofRectangle> tiles = makeTiles(numTiles, canvasWidth);
+    float canvasHeight = (numTiles / int(canvasWidth / TILE_SIZE) + 1) * TILE_SIZE;
+
+    beginGroup("spatial index, " + ofToString(numTiles) + " tiles");
+
+    SpatialIndex index;
+    Timer build;
+    index.reserve(numTiles);
+    for(size_t i = 0; i < tiles.size(); i++) {
+        index.insert(i, tiles[i]);
+    }
+    report("build", build.micros(), 1);
+
+    // Point queries, checked against the linear scan
+    const size_t numPoints = 10000;
+    vector<glm::vec2> points(numPoints);
+    for(auto& p : points) p = glm::vec2(ofRandom(canvasWidth), ofRandom(canvasHeight));
+
+    int misses = 0;
+    Timer gridPoint;
+    vector<int> gridHits(numPoints);
+    for(size_t i = 0; i < numPoints; i++) gridHits[i] = index.queryPoint(points[i].x, points[i].y);
+    report("point query (grid)", gridPoint.micros(), numPoints);
+
+    Timer linearPointTimer;
+    for(size_t i = 0; i < numPoints; i++) {
+        if(linearPoint(tiles, points[i].x, points[i].y) != gridHits[i]) misses++;
+    }
+    report("point query (linear)", linearPointTimer.micros(), numPoints);
+
+    // Marquee selections and viewport culls
+    vector<int> gridResult, linearResult;
+    auto benchRect = [&](const string& name, float width, float height, size_t count) {
+        vector<ofRectangle> rects(count);
+        for(auto& r : rects) r.set(ofRandom(canvasWidth), ofRandom(canvasHeight), width, height);
+
+        Timer grid;
+        size_t found = 0;
+        for(const auto& r : rects) {
+            index.queryRect(r, gridResult);
+            found += gridResult.size();
+        }
+        report(name + " (grid)", grid.micros(), count);
+
+        Timer linear;
+        size_t linearFound = 0;
+        for(const auto& r : rects) {
+            linearRect(tiles, r, linearResult);
+            linearFound += linearResult.size();
+        }
+        report(name + " (linear)", linear.micros(), count);
+        if(found != linearFound) misses++;
+    };
+    benchRect("marquee 400x300", 400, 300, 1000);
+    benchRect("viewport 1400x1050", 1400, 1050, 200);
+
+    // Group drag: 1000 tiles moved by a few pixels per frame
+    const size_t groupSize = 1000;
+    const int frames = 60;
+    Timer move;
+    for(int f = 0; f < frames; f++) {
+        for(size_t i = 0; i < groupSize; i++) {
+            tiles[i].x += 3;
+            index.update(i, tiles[i]);
+        }
+    }
+    report("group move, per tile", move.micros(), groupSize * frames);
+
+    for(size_t i = 0; i < groupSize; i++) {
+        if(index.queryPoint(tiles[i].getCenter().x, tiles[i].getCenter().y) !=
+           linearPoint(tiles, tiles[i].getCenter().x, tiles[i].getCenter().y)) {
+            misses++;
+        }
+    }
+
+    check(misses == 0, "spatial index differs from linear scan in " + ofToString(misses) + " queries");
+}
+
+// Select-all followed by the per-frame highlight work
+static void benchSelection(size_t numTiles) {
+    beginGroup("selection, " + ofToString(numTiles) + " tiles");
+    
+    SelectionSet selection;
+    Timer selectAll;
+    selection.selectAll(numTiles);
+    report("select all", selectAll.micros(), 1);
+    
+    Timer membership;
+    size_t selected = 0;
+    for(size_t i = 0; i < numTiles; i++) {
+        if(selection.contains(i)) selected++;
+    }
+    report("membership test", membership.micros(), numTiles);
+    
+    // The previous highlight check: linear find per tile
+    vector<int> list = selection.getIndices();
+    size_t sample = min<size_t>(numTiles, 1000);
+    Timer linear;
+    size_t linearSelected = 0;
+    for(size_t i = 0; i < sample; i++) {
+        if(find(list.begin(), list.end(), int(numTiles - 1 - i)) != list.end()) linearSelected++;
+    }
+    report("membership test (linear)", linear.micros(), sample);
+    
+    Timer clear;
+    selection.clear();
+    report("clear", clear.micros(), 1);
+    
+    check(selected == numTiles && linearSelected == sample, "selection membership");
+}
+
+// Smooth gradients with noise, so luma and hue vary across every tile
+static ofPixels makeFrame(int width, int height) {
+    ofPixels pixels;
+    pixels.allocate(width, height, OF_PIXELS_RGB);
+    for(int y = 0; y < height; y++) {
+        for(int x = 0; x < width; x++) {
+            size_t i = (size_t(y) * width + x) * 3;
+            pixels[i] = (x * 255 / width + int(ofRandom(16))) & 255;
+            pixels[i + 1] = (y * 255 / height + int(ofRandom(16))) & 255;
+            pixels[i + 2] = ((x + y) * 255 / (width + height)) & 255;
+        }
+    }
+    return pixels;
+}
+
+// Tile source regions covering a frame, edge tiles clipped like the app's
+static vector<ofRectangle> makeRegions(int width, int height) {
+    vector<ofRectangle> regions;
+    for(int y = 0; y < height; y += TILE_SIZE) {
+        for(int x = 0; x < width; x += TILE_SIZE) {
+            regions.emplace_back(x, y, min(TILE_SIZE, width - x), min(TILE_SIZE, height - y));
+        }
+    }
+    return regions;
+}
+
+// The frame as a decoder's Y plane would hold it: NV12 in video range, or
+// full range gray, with the chroma planes left neutral
+static ofPixels makeLumaFrame(const ofPixels& rgb, ofPixelFormat format) {
+    ofPixels luma;
+    luma.allocate(rgb.getWidth(), rgb.getHeight(), format);
+    memset(luma.getData(), 128, luma.size());
+    bool videoRange = format != OF_PIXELS_GRAY;
+    for(size_t i = 0; i < rgb.getWidth() * rgb.getHeight(); i++) {
+        float y = 0.299f * rgb[i * 3] + 0.587f * rgb[i * 3 + 1] + 0.114f * rgb[i * 3 + 2];
+        luma[i] = roundf(videoRange ? 16 + y * 219 / 255 : y);
+    }
+    return luma;
+}
+
+// Largest channel difference of the luma path from the RGB path over all tiles
+static int compareLuma(const ofPixels& rgb, const ofPixels& luma, const vector<ofRectangle>& regions,
+                       const ofColor& color1, const ofColor& color2) {
+    int maxDifference = 0;
+    ofPixels expected, actual;
+    for(const auto& region : regions) {
+        ColorRemap::remapToPalette(rgb, region, color1, color2, expected);
+        ColorRemap::remapToPalette(luma, region, color1, color2, actual);
+        if(expected.size() != actual.size()) return 255;
+        for(size_t i = 0; i < expected.size(); i++) {
+            maxDifference = max(maxDifference, abs(int(expected[i]) - int(actual[i])));
+        }
+    }
+    return maxDifference;
+}
+
+// Per-tile CPU work for one frame of a source: the crop every CPU path does,
+// then the crop plus the two-color remap from RGB and from the Y plane
+static void benchFrame(int width, int height) {
+    ofSeedRandom(2);
+    ofPixels frame = makeFrame(width, height);
+    vector<ofRectangle> regions = makeRegions(width, height);
+    const int frames = 10;
+    
+    beginGroup("frame " + ofToString(width) + "x" + ofToString(height) + ", " + ofToString(regions.size()) + " tiles");
+    
+    ofPixels tile;
+    Timer crop;
+    for(int f = 0; f < frames; f++) {
+        for(const auto& region : regions) {
+            frame.cropTo(tile, region.x, region.y, region.width, region.height);
+        }
+    }
+    report("region crop, per tile", crop.micros(), regions.size() * frames);
+    
+    ofColor color1(20, 40, 120);
+    ofColor color2(250, 200, 60);
+    Timer remap;
+    for(int f = 0; f < frames; f++) {
+        for(const auto& region : regions) {
+            ColorRemap::remapToPalette(frame, region, color1, color2, tile);
+        }
+    }
+    report("crop + remap, per tile", remap.micros(), regions.size() * frames);
+    report("crop + remap, per frame", remap.micros(), frames);
+    
+    ofPixels nv12 = makeLumaFrame(frame, OF_PIXELS_NV12);
+    Timer lumaRemap;
+    for(int f = 0; f < frames; f++) {
+        for(const auto& region : regions) {
+            ColorRemap::remapToPalette(nv12, region, color1, color2, tile);
+        }
+    }
+    report("Y plane remap, per frame", lumaRemap.micros(), frames);
+    
+    // Luma read from the Y plane lands within rounding of the RGB path
+    const int tolerance = 2;
+    int nv12Difference = compareLuma(frame, nv12, regions, color1, color2);
+    int grayDifference = compareLuma(frame, makeLumaFrame(frame, OF_PIXELS_GRAY), regions, color1, color2);
+    check(nv12Difference <= tolerance, "NV12 luma remap differs by " + ofToString(nv12Difference));
+    check(grayDifference <= tolerance, "gray luma remap differs by " + ofToString(grayDifference));
+    
+    // Spot check the kernel: black and white map to the two swatches
+    ofPixels extremes;
+    extremes.allocate(2, 1, OF_PIXELS_RGB);
+    extremes.setColor(0, 0, ofColor(0));
+    extremes.setColor(1, 0, ofColor(255));
+    ColorRemap::remapToPalette(extremes, ofRectangle(0, 0, 2, 1), color1, color2, tile);
+    check(tile.getColor(0, 0) == color1 && tile.getColor(1, 0) == color2, "remap endpoints");
+}
+
+// Upload regions of a 1080p source after most of its tiles were deleted:
+// building the set, then the frame copy into a pixel buffer, whole and
+// limited to the set
+static void benchRegions(size_t numTiles) {
+    ofSeedRandom(5);
+    const int width = 1920;
+    const int height = 1080;
+    vector<ofRectangle> regions = makeRegions(width, height);
+    ofRandomize(regions);
+    regions.resize(min(numTiles, regions.size()));
+    
+    beginGroup("upload regions, " + ofToString(regions.size()) + " of " +
+               ofToString(makeRegions(width, height).size()) + " tiles");
+    
+    RegionSet set;
+    const size_t builds = 100;
+    Timer build;
+    for(size_t i = 0; i < builds; i++) {
+        set = RegionSet();
+        set.update(width, height, regions);
+    }
+    report("build set", build.micros(), builds);
+    
+    ofPixels frame = makeFrame(width, height);
+    vector<unsigned char> buffer(frame.size(), 0);
+    const int frames = 50;
+    Timer full;
+    for(int f = 0; f < frames; f++) {
+        memcpy(buffer.data(), frame.getData(), frame.size());
+    }
+    report("full frame copy", full.micros(), frames);
+    
+    fill(buffer.begin(), buffer.end(), 0);
+    Timer limited;
+    for(int f = 0; f < frames; f++) {
+        RegionSet::copy(set.getRects(), width, frame.getData(), buffer.data(), 3);
+    }
+    report("region copy", limited.micros(), frames);
+    if(!jsonOutput) cout << "pixels saved " << ofToString(set.getSavedFraction() * 100, 1) << "%" << endl;
+    
+    // Every pixel a tile reads made it across
+    bool covered = true;
+    for(const auto& region : regions) {
+        for(int y = region.y; covered && y < region.getBottom(); y++) {
+            size_t offset = (size_t(y) * width + size_t(region.x)) * 3;
+            covered = memcmp(buffer.data() + offset, frame.getData() + offset, size_t(region.width) * 3) == 0;
+        }
+    }
+    check(covered, "region copy misses tile pixels");
+}
+
+// Swatch clustering on the downscaled primary frame, as the app runs it
+static void benchSwatches(int width, int height, int numSwatches) {
+    ofSeedRandom(3);
+    ofPixels small = makeFrame(width, height);
+    const size_t runs = 200;
+    
+    beginGroup("swatches " + ofToString(width) + "x" + ofToString(height));
+    
+    vector<ofColor> swatches;
+    Timer extract;
+    for(size_t i = 0; i < runs; i++) {
+        swatches = SwatchExtractor::extract(small, numSwatches);
+    }
+    report("k-means extract", extract.micros(), runs);
+    check(swatches.size() == numSwatches, "swatch count");
+}
+
+// Writing and reading a layout of image tiles through the same JSON fields
+// the app saves
+static void benchLayout(size_t numTiles) {
+    ofSeedRandom(4);
+    vector<ImageElement> tiles(numTiles);
+    for(size_t i = 0; i < numTiles; i++) {
+        tiles[i].setup((i % 100) * TILE_SIZE, (i / 100) * TILE_SIZE);
+        tiles[i].setImageRegion(i % 4, ofRectangle((i % 24) * TILE_SIZE, (i / 24 % 14) * TILE_SIZE, TILE_SIZE, TILE_SIZE));
+        tiles[i].setColorInput(i % 3 == 0);
+        tiles[i].setColorIndices(i % 6, (i + 1) % 6);
+        tiles[i].setPath("images/source" + ofToString(i % 4) + ".png");
+    }
+    
+    beginGroup("layout, " + ofToString(numTiles) + " tiles");
+    string path = "bench-layout.json";
+    
+    Timer serialize;
+    ofJson layout;
+    layout["imageTiles"] = ofJson::array();
+    for(const auto& tile : tiles) {
+        ofJson tileData;
+        tileData["imageIndex"] = tile.imageIndex;
+        tile.saveToJson(tileData);
+        tileData["path"] = tile.getPath();
+        layout["imageTiles"].push_back(tileData);
+    }
+    report("build json", serialize.micros(), 1);
+    
+    Timer write;
+    ofSavePrettyJson(path, layout);
+    report("write file", write.micros(), 1);
+    
+    Timer read;
+    ofJson loaded = ofLoadJson(path);
+    report("read file", read.micros(), 1);
+    
+    Timer parse;
+    vector<ImageElement> loadedTiles;
+    loadedTiles.reserve(numTiles);
+    for(const auto& tileData : loaded["imageTiles"]) {
+        ImageElement tile;
+        ofRectangle region = tile.loadFromJson(tileData);
+        tile.setImageRegion(tileData["imageIndex"], region);
+        tile.setPath(tileData["path"]);
+        loadedTiles.push_back(tile);
+    }
+    report("parse tiles", parse.micros(), 1);
+    
+    bool same = loadedTiles.size() == tiles.size();
+    for(size_t i = 0; same && i < tiles.size(); i++) {
+        same = loadedTiles[i].getTargetRect() == tiles[i].getTargetRect() &&
+               loadedTiles[i].sourceRegion == tiles[i].sourceRegion &&
+               loadedTiles[i].getColorIndex1() == tiles[i].getColorIndex1() &&
+               loadedTiles[i].hasColorInput() == tiles[i].hasColorInput();
+    }
+    check(same, "layout round trip");
+    ofFile::removeFile(path);
+}
+
+static void printJson() {
+    ofJson json;
+    json["mismatches"] = mismatches;
+    json["results"] = ofJson::array();
+    for(const auto& result : results) {
+        json["results"].push_back({
+            {"group", result.group},
+            {"name", result.name},
+            {"usPerOp", result.microsPerOp},
+            {"operations", result.operations}
+        });
+    }
+    cout << json.dump(2) << endl;
+}
+
+//========================================================================
+int main(int argc, char* argv[]) {
+    size_t numTiles = 50000;
+    for(int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if(arg == "--json") {
+            jsonOutput = true;
+        } else {
+            numTiles = ofToInt(arg);
+        }
+    }
+    
+    benchSpatialIndex(numTiles);
+    benchSelection(10000);
+    benchFrame(1280, 720);
+    benchFrame(1920, 1080);
+    benchFrame(3840, 2160);
+    benchRegions(12);
+    benchSwatches(64, 36, 6);
+    benchLayout(1000);
+    benchLayout(10000);
+    
+    if(jsonOutput) {
+        printJson();
+    } else {
+        cout << (mismatches == 0 ? "all checks passed" : ofToString(mismatches) + " checks failed") << endl;
+    }
+    return mismatches == 0 ? 0 : 1;
+}
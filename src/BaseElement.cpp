@@ -1,15 +1,129 @@
 #include "BaseElement.h"
+#include "ColorRemap.h"
+#include "Profiler.h"
 
 // Initialize static members
 ofTexture BaseElement::gradientTexture;
+ofPixels BaseElement::gradientPixels;
 bool BaseElement::showGradient = true;
+float BaseElement::gradientStrength = 1.0f;
+uint64_t BaseElement::paletteGeneration = 0;
 
 void BaseElement::loadGradientTexture() {
-    ofImage gradientImage;
-    if(gradientImage.load("gradient.png")) {
-        gradientTexture = gradientImage.getTexture();
+    if(ofLoadImage(gradientPixels, "gradient.png")) {
+        // Normalized coordinates so the tile pass can sample it per tile
+        gradientTexture.allocate(gradientPixels, false);
+        gradientTexture.loadData(gradientPixels);
         ofLog() << "Loaded gradient texture";
     } else {
         ofLog() << "Failed to load gradient texture";
     }
-} 
\ No newline at end of file
+}
+
+void BaseElement::drawGradient(const ofRectangle& target) {
+    if(!isGradientVisible()) return;
+    ofSetColor(255, 255, 255, 255 * gradientStrength);
+    gradientTexture.draw(target);
+    ofSetColor(255);
+}
+
+const ofTexture& BaseElement::uploadRemapped(ofPixels& pixels) const {
+    PROFILE_SCOPE("texture upload");
+    if(isGradientVisible()) {
+        ColorRemap::applyGradient(pixels, gradientPixels, gradientStrength);
+    }
+    remapTexture.loadData(pixels);
+    return remapTexture;
+}
+
+ResourceTracker::Usage BaseElement::getMemoryUsage() const {
+    ResourceTracker::Usage usage;
+    usage.cpu = sizeof(*this) + path.capacity();
+    usage.gpu = ResourceTracker::getBytes(remapTexture);
+    return usage;
+}
+
+bool BaseElement::isWarped() const {
+    for(const auto& offset : cornerOffsets) {
+        if(offset != glm::vec2(0)) return true;
+    }
+    return false;
+}
+
+void BaseElement::resetWarp() {
+    cornerOffsets.fill(glm::vec2(0));
+    perspectiveWarp = false;
+}
+
+TileQuad BaseElement::getTargetQuad() const {
+    ofRectangle target = getTargetRect();
+    if(!isWarped()) return TileQuad(target);
+    return TileQuad({{
+        glm::vec2(target.getLeft(), target.getTop()) + cornerOffsets[0],
+        glm::vec2(target.getRight(), target.getTop()) + cornerOffsets[1],
+        glm::vec2(target.getRight(), target.getBottom()) + cornerOffsets[2],
+        glm::vec2(target.getLeft(), target.getBottom()) + cornerOffsets[3]
+    }}, perspectiveWarp ? TileQuad::PERSPECTIVE : TileQuad::BILINEAR);
+}
+
+void BaseElement::saveToJson(ofJson& tileData) const {
+    tileData["x"] = x;
+    tileData["y"] = y;
+    tileData["offsetX"] = offsetX;
+    tileData["offsetY"] = offsetY;
+    tileData["sourceRegion"] = {
+        {"x", sourceRegion.x},
+        {"y", sourceRegion.y},
+        {"width", sourceRegion.width},
+        {"height", sourceRegion.height}
+    };
+    tileData["size"] = tileSize;
+    tileData["isPrimary"] = isPrimary();
+    tileData["useColorInput"] = hasColorInput();
+    tileData["colorIndex1"] = getColorIndex1();
+    tileData["colorIndex2"] = getColorIndex2();
+    tileData["output"] = getOutput();
+    if(isWarped()) {
+        tileData["corners"] = ofJson::array();
+        for(const auto& offset : cornerOffsets) {
+            tileData["corners"].push_back({offset.x, offset.y});
+        }
+        tileData["warp"] = perspectiveWarp ? "perspective" : "bilinear";
+    }
+}
+
+ofRectangle BaseElement::loadFromJson(const ofJson& tileData) {
+    setup(tileData["x"], tileData["y"]);
+    offsetX = tileData["offsetX"];
+    offsetY = tileData["offsetY"];
+    if(tileData.contains("size")) {
+        tileSize = tileData["size"];
+    }
+    
+    if(tileData.contains("isPrimary")) {
+        setPrimary(tileData["isPrimary"]);
+    }
+    if(tileData.contains("useColorInput")) {
+        setColorInput(tileData["useColorInput"]);
+    }
+    if(tileData.contains("colorIndex1") && tileData.contains("colorIndex2")) {
+        setColorIndices(tileData["colorIndex1"], tileData["colorIndex2"]);
+    }
+    if(tileData.contains("output")) {
+        setOutput(tileData["output"]);
+    }
+    resetWarp();
+    if(tileData.contains("corners") && tileData["corners"].size() == 4) {
+        for(int i = 0; i < 4; i++) {
+            cornerOffsets[i] = glm::vec2(tileData["corners"][i][0], tileData["corners"][i][1]);
+        }
+        perspectiveWarp = tileData.contains("warp") && tileData["warp"] == "perspective";
+    }
+    
+    return ofRectangle(
+        tileData["sourceRegion"]["x"],
+        tileData["sourceRegion"]["y"],
+        tileData["sourceRegion"]["width"],
+        tileData["sourceRegion"]["height"]
+    );
+}
@@ -1,10 +1,12 @@
 #pragma once
 #include "ofMain.h"
-#include "ofxOpenCv.h"
+#include "ofJson.h"
+#include "TileQuad.h"
+#include "ResourceTracker.h"
 
 class BaseElement {
 public:
-    static const int TILE_SIZE = 80;
+    static const int TILE_SIZE = 80;    // size new sources are sliced at unless chosen otherwise
     
     // Add virtual destructor
     virtual ~BaseElement() = default;
@@ -17,15 +19,27 @@ public:
     
     // Static texture shared by all instances
     static ofTexture gradientTexture;
+    static ofPixels gradientPixels;    // CPU copy, blended into CPU-remapped tiles
     static bool showGradient;
+    static float gradientStrength;     // overlay opacity, the same for every element type
     static void loadGradientTexture();
     static void toggleGradient() { showGradient = !showGradient; }
     
+    // Bumped whenever the color swatches change, so cached remaps can tell they are stale
+    static uint64_t paletteGeneration;
+    static bool isGradientVisible() {
+        return showGradient && gradientTexture.isAllocated() && gradientStrength > 0;
+    }
+    
+    // Overlay for the unbatched fallback path
+    static void drawGradient(const ofRectangle& target);
+    
     // Common methods
     virtual void setup(float x, float y) {
         this->x = x;
         this->y = y;
         offsetX = offsetY = 0;
+        tileSize = TILE_SIZE;
         isLoaded = false;
     }
     
@@ -48,19 +62,58 @@ public:
     int getColorIndex1() const { return colorIndex1; }
     int getColorIndex2() const { return colorIndex2; }
     
+    // Output window the tile is shown on, 0 being the main window
+    int getOutput() const { return outputIndex; }
+    void setOutput(int output) { outputIndex = output; }
+    
     // Path handling
     void setPath(const string& p) { path = p; }
     string getPath() const { return path; }
     
+    // Size of the square the tile is drawn into, independent of its source region
+    float getTileSize() const { return tileSize; }
+    void setTileSize(float size) { tileSize = size; }
+    
+    ofRectangle getTargetRect() const { return ofRectangle(x + offsetX, y + offsetY, tileSize, tileSize); }
+    
+    // Corner warp: how far each target corner is moved, clockwise from the
+    // top-left. All zero draws the plain square.
+    glm::vec2 getCornerOffset(int corner) const { return cornerOffsets[corner]; }
+    void setCornerOffset(int corner, const glm::vec2& offset) { cornerOffsets[corner] = offset; }
+    bool hasPerspectiveWarp() const { return perspectiveWarp; }
+    void setPerspectiveWarp(bool perspective) { perspectiveWarp = perspective; }
+    bool isWarped() const;
+    void resetWarp();
+    
+    // Target square with the corner warp applied
+    TileQuad getTargetQuad() const;
+    // Screen area the tile covers, warp included
+    ofRectangle getBounds() const { return getTargetQuad().getBounds(); }
+    
+    // The tile itself and its CPU remap texture; sources are counted on their own
+    ResourceTracker::Usage getMemoryUsage() const;
+    
+    // Layout fields every tile kind shares: position, offsets, source
+    // region, size, primary and color input settings, output, corner warp
+    void saveToJson(ofJson& tileData) const;
+    // Sets up the tile from those fields and returns the stored source region
+    ofRectangle loadFromJson(const ofJson& tileData);
+    
 protected:
+    // Uploads CPU-remapped pixels with the gradient already blended in
+    const ofTexture& uploadRemapped(ofPixels& pixels) const;
+    
+
     bool isPrimaryElement = false;
     bool useColorInput = false;
     int colorIndex1 = 0;
     int colorIndex2 = 1;
+    int outputIndex = 0;
+    float tileSize = TILE_SIZE;
+    array<glm::vec2, 4> cornerOffsets = {{glm::vec2(0), glm::vec2(0), glm::vec2(0), glm::vec2(0)}};
+    bool perspectiveWarp = false;
     string path;
     
-    // OpenCV image processing
-    mutable ofxCvColorImage cvImage;
-    mutable ofxCvGrayscaleImage grayImage;
-    mutable bool isCvImageAllocated = false;
+    // Result of the CPU color remap
+    mutable ofTexture remapTexture;
 }; 
\ No newline at end of file
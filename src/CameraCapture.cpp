@@ -0,0 +1,210 @@
+#include "CameraCapture.h"
+#include "TraceRecorder.h"
+#include "ColorRemap.h"
+
+CameraCapture::CameraCapture() {
+}
+
+CameraCapture::~CameraCapture() {
+    close();
+}
+
+vector<ofVideoDevice> CameraCapture::listDevices() {
+    ofVideoGrabber lister;
+    return lister.listDevices();
+}
+
+bool CameraCapture::setup(const Settings& newSettings) {
+    std::lock_guard<std::mutex> lock(grabberMutex);
+
+    if(grabber.isInitialized()) grabber.close();
+    if(player.isLoaded()) player.close();
+    initialized = false;
+    if(!(newSettings == settings)) {
+        lumaUnsupported = false;
+    }
+    settings = newSettings;
+    ring.clear();
+    ringChecked = false;
+
+    // Texture uploads happen on the render thread, never on the capture thread
+    if(lumaOnly && !requestLuma()) {
+        ofLogWarning() << "No luma capture for camera " << settings.deviceId << ", using RGB from now on";
+        lumaOnly = false;
+        lumaUnsupported = true;
+    }
+    if(!lumaOnly) {
+        player.setPixelFormat(OF_PIXELS_RGB);
+        grabber.setPixelFormat(OF_PIXELS_RGB);
+    }
+
+    if(settings.isVirtual()) {
+        player.setUseTexture(false);
+        if(!player.load(settings.videoPath)) {
+            ofLogError() << "Failed to open virtual camera: " << settings.videoPath;
+            return false;
+        }
+        player.setLoopState(OF_LOOP_NORMAL);
+        player.play();
+        width = player.getWidth();
+        height = player.getHeight();
+    } else {
+        grabber.setUseTexture(false);
+        grabber.setDeviceID(settings.deviceId);
+        grabber.setDesiredFrameRate(settings.frameRate);
+        if(!grabber.setup(settings.width, settings.height)) {
+            ofLogError() << "Failed to open camera " << settings.deviceId;
+            return false;
+        }
+        width = grabber.getWidth();
+        height = grabber.getHeight();
+    }
+
+    initialized = true;
+    return true;
+}
+
+bool CameraCapture::requestLuma() {
+    // Prefer the source's native planar layout, then plain gray
+    if(settings.isVirtual()) {
+        return player.setPixelFormat(OF_PIXELS_NV12) || player.setPixelFormat(OF_PIXELS_GRAY);
+    }
+    return grabber.setPixelFormat(OF_PIXELS_NV12) || grabber.setPixelFormat(OF_PIXELS_GRAY);
+}
+
+bool CameraCapture::setLumaOnly(bool enabled) {
+    if(enabled == lumaOnly || !initialized) return lumaOnly;
+    if(enabled && lumaUnsupported) return false;
+    lumaOnly = enabled;
+    setup(settings);
+    return lumaOnly;
+}
+
+void CameraCapture::setTileRegions(const vector<ofRectangle>& regions) {
+    if(regionSet.update(width, height, regions)) {
+        applyRegions();
+    }
+}
+
+void CameraCapture::applyRegions() {
+    if(regionSet.isFullFrame()) {
+        ring.setFullFrame();
+    } else {
+        ring.setRegions(regionSet.getRects());
+    }
+}
+
+void CameraCapture::close() {
+    std::lock_guard<std::mutex> lock(grabberMutex);
+    initialized = false;
+    if(grabber.isInitialized()) grabber.close();
+    if(player.isLoaded()) player.close();
+    ring.clear();
+}
+
+bool CameraCapture::grab() {
+    std::lock_guard<std::mutex> lock(grabberMutex);
+    if(!initialized) return false;
+
+    if(settings.isVirtual()) {
+#ifdef TILE_PROFILER
+        // Only polls that decoded a frame are traced
+        int64_t decodeStart = TraceRecorder::isRecording() ? TraceRecorder::now() : -1;
+#endif
+        player.update();
+        if(!player.isFrameNew()) return false;
+#ifdef TILE_PROFILER
+        if(decodeStart >= 0) TraceRecorder::add("virtual decode", decodeStart);
+#endif
+        TRACE_SCOPE("capture publish");
+        publish(player.getPixels());
+    } else {
+        grabber.update();
+        if(!grabber.isFrameNew()) return false;
+        TRACE_SCOPE("capture publish");
+        publish(grabber.getPixels());
+    }
+    return true;
+}
+
+void CameraCapture::publish(const ofPixels& pixels) {
+    uint64_t captureTime = ofGetElapsedTimeMicros();
+    
+    // Write straight into a mapped upload buffer when the GPU path is up
+    if(ring.write(pixels, captureTime) && !keepPixels) return;
+    
+    // Fill the back slot, then swap it into the hand-off slot
+    Frame& frame = frames[writeIndex];
+    frame.pixels = pixels;
+    frame.captureTimeMicros = captureTime;
+    frame.frameNumber = ++framesCaptured;
+
+    int previous = readyIndex.exchange(writeIndex | NEW_FRAME_BIT);
+    writeIndex = previous & ~NEW_FRAME_BIT;
+}
+
+bool CameraCapture::update() {
+    frameIsNew = false;
+    uint64_t captureTime = 0;
+    
+    if(readyIndex.load() & NEW_FRAME_BIT) {
+        // Take the newest frame and give our old slot back to the capture thread
+        int previous = readyIndex.exchange(readIndex);
+        readIndex = previous & ~NEW_FRAME_BIT;
+        
+        const Frame& frame = frames[readIndex];
+        if(ColorRemap::isLumaFormat(frame.pixels.getPixelFormat())) {
+            // Luma frames are only read by the CPU remap, nothing to upload
+            frameIsNew = true;
+            captureTime = frame.captureTimeMicros;
+        } else if(frame.pixels.isAllocated() && !ring.isAllocated()) {
+            // The first frame tells us what to allocate the upload ring for
+            if(!ringChecked) {
+                ringChecked = true;
+                if(ring.allocate(frame.pixels.getWidth(), frame.pixels.getHeight(), frame.pixels.getPixelFormat())) {
+                    applyRegions();
+                    ring.write(frame.pixels, frame.captureTimeMicros);
+                }
+            }
+            
+            // No pixel buffers available, upload from the CPU copy
+            if(!ring.isAllocated()) {
+                texture.loadData(frame.pixels);
+                frameIsNew = true;
+                captureTime = frame.captureTimeMicros;
+            }
+        }
+    }
+    
+    if(ring.update()) {
+        frameIsNew = true;
+        captureTime = ring.getTimestamp();
+    }
+    
+    if(!frameIsNew) return false;
+    
+    latencyMillis = (ofGetElapsedTimeMicros() - captureTime) / 1000.0f;
+    averageLatencyMillis = averageLatencyMillis == 0 ? latencyMillis
+                         : averageLatencyMillis * 0.95f + latencyMillis * 0.05f;
+    return true;
+}
+
+ResourceTracker::Usage CameraCapture::getMemoryUsage() {
+    ResourceTracker::Usage usage;
+    if(!initialized) return usage;
+    
+    for(const auto& frame : frames) {
+        usage.cpu += ResourceTracker::getBytes(frame.pixels);
+    }
+    {
+        // The capture thread owns the grabber
+        std::lock_guard<std::mutex> lock(grabberMutex);
+        usage.cpu += isVirtual() ? ResourceTracker::getBytes(player.getPixels())
+                                 : ResourceTracker::getBytes(grabber.getPixels());
+    }
+    usage.gpu = ResourceTracker::getBytes(texture);
+    if(ring.isAllocated()) {
+        usage.gpu += ring.getBufferBytes() + ResourceTracker::getBytes(ring.getTexture());
+    }
+    return usage;
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include "ofMain.h"
+#include "PixelBufferRing.h"
+#include "RegionSet.h"
+#include "ResourceTracker.h"
+#include <atomic>
+
+// Camera source whose frames are grabbed off the main thread. Frames are
+// handed to the render thread through a lock-free triple buffer, so the
+// renderer always sees the newest complete frame without waiting on capture.
+// Where pixel buffer objects are available the capture thread also writes
+// each frame straight into a mapped upload buffer, and the texture update
+// runs asynchronously on the GPU.
+//
+// A camera is either a capture device or a "virtual camera" that loops a
+// video file, which lets camera layouts be tested without hardware.
+class CameraCapture {
+public:
+    struct Settings {
+        int deviceId = 0;
+        int width = 640;
+        int height = 480;
+        int frameRate = 30;
+        string videoPath;    // non-empty for a virtual camera
+
+        bool isVirtual() const { return !videoPath.empty(); }
+        bool operator==(const Settings& other) const {
+            return deviceId == other.deviceId && width == other.width &&
+                   height == other.height && frameRate == other.frameRate &&
+                   videoPath == other.videoPath;
+        }
+    };
+
+    CameraCapture();
+    ~CameraCapture();
+
+    static vector<ofVideoDevice> listDevices();
+
+    bool setup(const Settings& settings);
+    void close();
+
+    // Capture thread: polls the grabber and publishes any new frame
+    bool grab();
+
+    // Render thread: swaps in the newest published frame and uploads it.
+    // Returns true if a new frame arrived since the last call.
+    bool update();
+
+    const Settings& getSettings() const { return settings; }
+    bool isVirtual() const { return settings.isVirtual(); }
+    bool isInitialized() const { return initialized; }
+    bool isFrameNew() const { return frameIsNew; }
+    float getWidth() const { return width; }
+    float getHeight() const { return height; }
+
+    // Pixels and texture of the frame currently on display
+    const ofPixels& getPixels() const { return frames[readIndex].pixels; }
+    const ofTexture& getTexture() const { return ring.isAllocated() ? ring.getTexture() : texture; }
+
+    // CPU pixels are only kept up to date while something reads them
+    void setKeepPixels(bool keep) { keepPixels = keep; }
+    // False while frames go straight to the upload ring, getPixels() is stale then
+    bool hasCurrentPixels() const { return keepPixels || !ring.isAllocated(); }
+
+    // Reopens the source delivering the Y plane only, for cameras read only
+    // by CPU color remaps. Luma frames are not uploaded, so there is no
+    // texture while this is on.
+    bool setLumaOnly(bool lumaOnly);
+    bool isLumaOnly() const { return lumaOnly; }
+    // The source turned luma only down once, so it is never asked again
+    bool isLumaUnsupported() const { return lumaUnsupported; }
+
+    // Limits copies into the upload ring and texture uploads to the areas
+    // these tile regions read; render thread
+    void setTileRegions(const vector<ofRectangle>& regions);
+    const RegionSet& getRegionSet() const { return regionSet; }
+
+    // Capture-to-display latency of the current frame, in milliseconds
+    float getLatencyMillis() const { return latencyMillis; }
+    float getAverageLatencyMillis() const { return averageLatencyMillis; }
+    uint64_t getFrameNumber() const { return frames[readIndex].frameNumber; }
+    
+    // Triple buffer, grabber or player pixels, texture and upload buffers
+    ResourceTracker::Usage getMemoryUsage();
+
+private:
+    struct Frame {
+        ofPixels pixels;
+        uint64_t captureTimeMicros = 0;
+        uint64_t frameNumber = 0;
+    };
+
+    void publish(const ofPixels& pixels);
+    void applyRegions();
+    bool requestLuma();
+
+    // The ready slot index is packed with this flag when it holds an unread frame
+    static const int NEW_FRAME_BIT = 4;
+
+    Frame frames[3];
+    int writeIndex = 0;                // owned by the capture thread
+    int readIndex = 2;                 // owned by the render thread
+    std::atomic<int> readyIndex{1};    // shared hand-off slot
+    uint64_t framesCaptured = 0;
+
+    Settings settings;
+    ofVideoGrabber grabber;
+    ofVideoPlayer player;              // backs a virtual camera
+    std::mutex grabberMutex;
+    ofTexture texture;
+    PixelBufferRing ring;
+    bool ringChecked = false;
+    RegionSet regionSet;
+    std::atomic<bool> keepPixels{true};
+    bool lumaOnly = false;
+    bool lumaUnsupported = false;      // for these settings
+
+    std::atomic<bool> initialized{false};
+    float width = 0;
+    float height = 0;
+    bool frameIsNew = false;
+    float latencyMillis = 0;
+    float averageLatencyMillis = 0;
+};
@@ -1,4 +1,6 @@
 #include "CameraElement.h"
+#include "ColorRemap.h"
+#include "Profiler.h"
 
 CameraElement::CameraElement() {
     offsetX = offsetY = 0;
@@ -8,68 +10,72 @@ CameraElement::CameraElement() {
 }
 
 void CameraElement::update() {
-    // Camera updates are handled by ofVideoGrabber in the main app
+    // Camera frames are captured by CaptureService and swapped in by the main app
 }
 
-void CameraElement::draw(const vector<ofVideoGrabber>& cameras, const vector<ofColor>& colorSwatches, bool isEditMode, int index) {
+void CameraElement::draw(const vector<shared_ptr<CameraCapture>>& cameras, const vector<ofColor>& colorSwatches) {
+    PROFILE_SCOPE("tile draw");
     if(cameraIndex >= cameras.size()) return;
     
     const auto& camera = cameras[cameraIndex];
-    if(!camera.isInitialized()) return;
+    if(!camera || !camera->isInitialized()) return;
+    // Luma only cameras have no texture, their tiles remap on the CPU
+    if(!camera->isLumaOnly() && !camera->getTexture().isAllocated()) return;
     
-    ofPushMatrix();
-    ofTranslate(x + offsetX, y + offsetY);
+    ofRectangle target = getTargetRect();
     
     if(useColorInput && colorSwatches.size() > max(colorIndex1, colorIndex2)) {
-        // Get the camera frame pixels for our region
-        ofPixels cameraPixels = camera.getPixels();
-        ofPixels regionPixels;
-        cameraPixels.cropTo(regionPixels, 
-            sourceRegion.x, sourceRegion.y, 
-            sourceRegion.width, sourceRegion.height);
-        
-        // Process pixels directly like VideoElement
-        for(size_t i = 0; i < regionPixels.size(); i += regionPixels.getNumChannels()) {
-            float r = regionPixels[i];
-            float g = regionPixels[i + 1];
-            float b = regionPixels[i + 2];
-            
-            // Calculate brightness using perceived luminance weights
-            float brightness = (0.299f * r + 0.587f * g + 0.114f * b) / 255.0f;
-            
-            // Interpolate between colors based on brightness
-            ofColor result = colorSwatches[colorIndex1].getLerped(colorSwatches[colorIndex2], brightness);
-            
-            regionPixels[i] = result.r;
-            regionPixels[i + 1] = result.g;
-            regionPixels[i + 2] = result.b;
+        if(ColorRemap::isShaderEnabled() && !camera->isLumaOnly()) {
+            // Remap on the GPU straight from the camera texture
+            ColorRemap::drawSubsection(camera->getTexture(), target, sourceRegion, colorIndex1, colorIndex2);
+            drawGradient(target);
+        } else if(camera->getPixels().isAllocated()) {
+            // CPU reference path, gradient is baked in
+            remapOnCpu(*camera, colorSwatches).draw(target);
         }
-        
-        ofTexture tex;
-        tex.loadData(regionPixels);
-        tex.draw(0, 0, TILE_SIZE, TILE_SIZE);
     } else {
         // Draw normal camera segment
-        camera.getTexture().drawSubsection(0, 0, TILE_SIZE, TILE_SIZE,
+        camera->getTexture().drawSubsection(target.x, target.y, target.width, target.height,
                                          sourceRegion.x, sourceRegion.y,
                                          sourceRegion.width, sourceRegion.height);
+        drawGradient(target);
     }
+}
+
+void CameraElement::addToBatch(TileRenderer& renderer, const vector<shared_ptr<CameraCapture>>& cameras,
+                               const vector<ofColor>& colorSwatches) {
+    PROFILE_SCOPE("tile batch");
+    if(cameraIndex >= cameras.size()) return;
     
-    // Draw gradient overlay if enabled
-    if(showGradient && gradientTexture.isAllocated()) {
-        ofSetColor(255, 255, 255, 128);
-        gradientTexture.draw(0, 0, TILE_SIZE, TILE_SIZE);
-        ofSetColor(255, 255, 255, 255);
-    }
-    
-    ofPopMatrix();
+    const auto& camera = cameras[cameraIndex];
+    if(!camera || !camera->isInitialized()) return;
+    if(!camera->isLumaOnly() && !camera->getTexture().isAllocated()) return;
     
-    // Draw index if in edit mode
-    if(isEditMode) {
-        ofDrawBitmapStringHighlight(ofToString(index), x + 5, y + 15);
+    if(useColorInput && colorSwatches.size() > max(colorIndex1, colorIndex2)) {
+        if(ColorRemap::isShaderEnabled() && !camera->isLumaOnly()) {
+            renderer.add(camera->getTexture(), getTargetQuad(), sourceRegion, true, colorIndex1, colorIndex2);
+        } else if(camera->getPixels().isAllocated()) {
+            const ofTexture& remapped = remapOnCpu(*camera, colorSwatches);
+            renderer.add(remapped, getTargetQuad(), ofRectangle(0, 0, remapped.getWidth(), remapped.getHeight()),
+                         false, 0, 0, false);
+        }
+    } else {
+        renderer.add(camera->getTexture(), getTargetQuad(), sourceRegion);
     }
 }
 
+const ofTexture& CameraElement::remapOnCpu(const CameraCapture& camera, const vector<ofColor>& colorSwatches) const {
+    PROFILE_SCOPE("cpu remap");
+    ofPixels regionPixels;
+    ColorRemap::remapToPalette(camera.getPixels(), sourceRegion,
+                               colorSwatches[colorIndex1], colorSwatches[colorIndex2], regionPixels);
+    return uploadRemapped(regionPixels);
+}
+
+void CameraElement::drawLabel(int index) const {
+    ofDrawBitmapStringHighlight(ofToString(index), x + 5, y + 15);
+}
+
 void CameraElement::setCameraRegion(size_t index, const ofRectangle& region) {
     cameraIndex = index;
     sourceRegion = region;
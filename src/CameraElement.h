@@ -1,5 +1,7 @@
 #pragma once
 #include "BaseElement.h"
+#include "CameraCapture.h"
+#include "TileRenderer.h"
 
 class CameraElement : public BaseElement {
 public:
@@ -7,8 +9,10 @@ public:
     virtual ~CameraElement() = default;
     
     void update();
-    void draw(const vector<ofVideoGrabber>& cameras, const vector<ofColor>& colorSwatches, 
-             bool isEditMode, int index);
+    void draw(const vector<shared_ptr<CameraCapture>>& cameras, const vector<ofColor>& colorSwatches);
+    void addToBatch(TileRenderer& renderer, const vector<shared_ptr<CameraCapture>>& cameras,
+                    const vector<ofColor>& colorSwatches);
+    void drawLabel(int index) const;
              
     void setCameraRegion(size_t index, const ofRectangle& region);
     
@@ -19,4 +23,5 @@ public:
 private:
     // Helper function for color processing
     void processColors(const ofPixels& pixels, const vector<ofColor>& colorSwatches) const;
+    const ofTexture& remapOnCpu(const CameraCapture& camera, const vector<ofColor>& colorSwatches) const;
 }; 
\ No newline at end of file
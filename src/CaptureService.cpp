@@ -0,0 +1,108 @@
+#include "CaptureService.h"
+#include "TraceRecorder.h"
+
+CaptureService::CaptureService() {
+    deviceWorker = make_shared<Worker>();
+}
+
+CaptureService::~CaptureService() {
+    stop();
+}
+
+void CaptureService::start() {
+    running = true;
+    startWorker(*deviceWorker);
+    for(auto& worker : virtualWorkers) {
+        startWorker(*worker);
+    }
+}
+
+void CaptureService::stop() {
+    running = false;
+    stopWorker(*deviceWorker);
+    for(auto& worker : virtualWorkers) {
+        stopWorker(*worker);
+    }
+}
+
+void CaptureService::add(const shared_ptr<CameraCapture>& capture) {
+    if(capture->isVirtual()) {
+        auto worker = make_shared<Worker>();
+        worker->add(capture);
+        virtualWorkers.push_back(worker);
+        if(running) startWorker(*worker);
+    } else {
+        deviceWorker->add(capture);
+    }
+}
+
+void CaptureService::remove(const shared_ptr<CameraCapture>& capture) {
+    if(deviceWorker->remove(capture)) return;
+    
+    for(auto it = virtualWorkers.begin(); it != virtualWorkers.end(); ++it) {
+        if((*it)->remove(capture)) {
+            stopWorker(**it);
+            virtualWorkers.erase(it);
+            return;
+        }
+    }
+}
+
+void CaptureService::clear() {
+    deviceWorker->clear();
+    for(auto& worker : virtualWorkers) {
+        stopWorker(*worker);
+    }
+    virtualWorkers.clear();
+}
+
+void CaptureService::startWorker(Worker& worker) {
+    if(!worker.isThreadRunning()) {
+        worker.startThread();
+    }
+}
+
+void CaptureService::stopWorker(Worker& worker) {
+    if(worker.isThreadRunning()) {
+        worker.stopThread();
+        worker.waitForThread(false);
+    }
+}
+
+void CaptureService::Worker::add(const shared_ptr<CameraCapture>& capture) {
+    std::lock_guard<std::mutex> lock(mutex);
+    captures.push_back(capture);
+}
+
+bool CaptureService::Worker::remove(const shared_ptr<CameraCapture>& capture) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = std::find(captures.begin(), captures.end(), capture);
+    if(it == captures.end()) return false;
+    captures.erase(it);
+    return true;
+}
+
+void CaptureService::Worker::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    captures.clear();
+}
+
+void CaptureService::Worker::threadedFunction() {
+    TraceRecorder::setThreadName("capture");
+    while(isThreadRunning()) {
+        bool grabbedAny = false;
+        {
+            // Held for the whole pass, so once remove() returns the camera is
+            // no longer referenced here and is always released on the main thread
+            std::lock_guard<std::mutex> lock(mutex);
+            for(auto& capture : captures) {
+                grabbedAny |= capture->grab();
+            }
+        }
+        
+        // Nothing new from any camera, back off briefly instead of spinning
+        if(!grabbedAny) {
+            sleep(1);
+        }
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "ofMain.h"
+#include "CameraCapture.h"
+
+// Runs the capture threads that poll cameras and publish new frames into
+// their triple buffers, keeping grabber work off the render thread.
+//
+// Capture devices deliver frames through their own driver callbacks, so
+// polling them is cheap and they all share one thread. Virtual cameras
+// decode video on the polling thread, so each gets a thread of its own and
+// a slow decode never holds back a live camera.
+class CaptureService {
+public:
+    CaptureService();
+    ~CaptureService();
+
+    void start();
+    void stop();
+
+    void add(const shared_ptr<CameraCapture>& capture);
+    void remove(const shared_ptr<CameraCapture>& capture);
+    void clear();
+
+    size_t getNumThreads() const { return 1 + virtualWorkers.size(); }
+
+private:
+    class Worker : public ofThread {
+    public:
+        void add(const shared_ptr<CameraCapture>& capture);
+        bool remove(const shared_ptr<CameraCapture>& capture);
+        void clear();
+
+    protected:
+        void threadedFunction() override;
+
+    private:
+        vector<shared_ptr<CameraCapture>> captures;
+    };
+
+    void startWorker(Worker& worker);
+    void stopWorker(Worker& worker);
+
+    shared_ptr<Worker> deviceWorker;
+    vector<shared_ptr<Worker>> virtualWorkers;
+    bool running = false;
+};
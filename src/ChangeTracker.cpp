@@ -0,0 +1,65 @@
+#include "ChangeTracker.h"
+
+void ChangeTracker::addDirtyRect(const ofRectangle& rect) {
+    // Only the visible part matters
+    ofRectangle visible = rect.getIntersection(ofRectangle(0, 0, ofGetWidth(), ofGetHeight()));
+    if(visible.width <= 0 || visible.height <= 0) return;
+    dirtyRects.push_back(visible);
+}
+
+void ChangeTracker::checkPalette(uint64_t generation) {
+    if(generation != paletteGeneration) {
+        paletteGeneration = generation;
+        fullRedraw = true;
+    }
+}
+
+bool ChangeTracker::isFullRedraw() const {
+    return fullRedraw || !fbo.isAllocated() ||
+           fbo.getWidth() != ofGetWidth() || fbo.getHeight() != ofGetHeight();
+}
+
+bool ChangeTracker::hasChanges() const {
+    return isFullRedraw() || !dirtyRects.empty();
+}
+
+void ChangeTracker::begin() {
+    if(!fbo.isAllocated() || fbo.getWidth() != ofGetWidth() || fbo.getHeight() != ofGetHeight()) {
+        fbo.allocate(ofGetWidth(), ofGetHeight(), GL_RGBA);
+    }
+    fbo.begin();
+}
+
+void ChangeTracker::end() {
+    fbo.end();
+}
+
+void ChangeTracker::beginRegion(const ofRectangle& rect) {
+    // Frame buffers are rendered flipped, so rows already count from the top
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(floor(rect.x), floor(rect.y), ceil(rect.width) + 1, ceil(rect.height) + 1);
+}
+
+void ChangeTracker::endRegion() {
+    glDisable(GL_SCISSOR_TEST);
+}
+
+void ChangeTracker::draw() const {
+    if(!fbo.isAllocated()) return;
+    ofPushStyle();
+    ofSetColor(255);
+    fbo.draw(0, 0);
+    ofPopStyle();
+}
+
+void ChangeTracker::frameDone() {
+    if(isFullRedraw()) {
+        framesFull++;
+    } else if(!dirtyRects.empty()) {
+        framesPartial++;
+    } else {
+        framesSkipped++;
+    }
+    dirtyRects.clear();
+    if(fbo.isAllocated()) fullRedraw = false;
+}
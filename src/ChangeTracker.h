@@ -0,0 +1,51 @@
+#pragma once
+#include "ofMain.h"
+
+// Frame-level change tracking for the output. The composited frame is kept
+// in a persistent buffer; when nothing changed it is shown again as is,
+// and when only some sources produced new frames just their screen regions
+// are redrawn into it.
+//
+// Anything that can change the whole picture (layout edits, palette
+// changes, GUI, resizes) calls invalidate() for a full redraw.
+class ChangeTracker {
+public:
+    void invalidate() { fullRedraw = true; }
+    void addDirtyRect(const ofRectangle& rect);
+    
+    // Invalidates when the palette generation moves
+    void checkPalette(uint64_t generation);
+    
+    bool hasChanges() const;
+    bool isFullRedraw() const;
+    const vector<ofRectangle>& getDirtyRects() const { return dirtyRects; }
+    
+    // Redirects drawing into the frame buffer until end()
+    void begin();
+    void end();
+    
+    // Limits drawing to one dirty rectangle between begin() and end()
+    void beginRegion(const ofRectangle& rect);
+    void endRegion();
+    
+    // Shows the last composited frame
+    void draw() const;
+    
+    // Counts since startup
+    uint64_t getFramesSkipped() const { return framesSkipped; }
+    uint64_t getFramesPartial() const { return framesPartial; }
+    uint64_t getFramesFull() const { return framesFull; }
+    
+    // Called once per frame after draw()
+    void frameDone();
+    
+private:
+    ofFbo fbo;
+    vector<ofRectangle> dirtyRects;
+    bool fullRedraw = true;
+    uint64_t paletteGeneration = 0;
+    
+    uint64_t framesSkipped = 0;
+    uint64_t framesPartial = 0;
+    uint64_t framesFull = 0;
+};
@@ -0,0 +1,273 @@
+#include "ColorRemap.h"
+
+ofShader ColorRemap::rectShader;
+ofShader ColorRemap::shader2D;
+ofTexture ColorRemap::paletteTexture;
+vector<ofColor> ColorRemap::paletteColors;
+bool ColorRemap::shaderAvailable = false;
+bool ColorRemap::useShader = true;
+
+// Luma weights match the CPU kernel below
+static const string FRAGMENT_BODY_GL2 = R"(
+uniform SAMPLER source;
+uniform sampler2D palette;
+uniform float paletteSize;
+uniform float color1;
+uniform float color2;
+
+void main() {
+    vec3 rgb = TEXTURE(source, gl_TexCoord[0].xy).rgb;
+    float luma = dot(rgb, vec3(0.299, 0.587, 0.114));
+    vec3 c1 = texture2D(palette, vec2((color1 + 0.5) / paletteSize, 0.5)).rgb;
+    vec3 c2 = texture2D(palette, vec2((color2 + 0.5) / paletteSize, 0.5)).rgb;
+    gl_FragColor = vec4(mix(c1, c2, luma), 1.0) * gl_Color;
+}
+)";
+
+static const string VERTEX_GL2 = R"(#version 120
+void main() {
+    gl_TexCoord[0] = gl_MultiTexCoord0;
+    gl_FrontColor = gl_Color;
+    gl_Position = ftransform();
+}
+)";
+
+static const string FRAGMENT_BODY_GL3 = R"(
+uniform SAMPLER source;
+uniform sampler2D palette;
+uniform float paletteSize;
+uniform float color1;
+uniform float color2;
+uniform vec4 globalColor;
+
+in vec2 texCoordVarying;
+out vec4 fragColor;
+
+void main() {
+    vec3 rgb = texture(source, texCoordVarying).rgb;
+    float luma = dot(rgb, vec3(0.299, 0.587, 0.114));
+    vec3 c1 = texture(palette, vec2((color1 + 0.5) / paletteSize, 0.5)).rgb;
+    vec3 c2 = texture(palette, vec2((color2 + 0.5) / paletteSize, 0.5)).rgb;
+    fragColor = vec4(mix(c1, c2, luma), 1.0) * globalColor;
+}
+)";
+
+static const string VERTEX_GL3 = R"(#version 150
+uniform mat4 modelViewProjectionMatrix;
+in vec4 position;
+in vec2 texcoord;
+out vec2 texCoordVarying;
+
+void main() {
+    texCoordVarying = texcoord;
+    gl_Position = modelViewProjectionMatrix * position;
+}
+)";
+
+bool ColorRemap::isLumaFormat(ofPixelFormat format) {
+    switch(format) {
+        case OF_PIXELS_GRAY:
+        case OF_PIXELS_Y:
+        case OF_PIXELS_NV12:
+        case OF_PIXELS_NV21:
+        case OF_PIXELS_YV12:
+        case OF_PIXELS_I420:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void ColorRemap::remapToPalette(const ofPixels& source, const ofRectangle& region,
+                                const ofColor& color1, const ofColor& color2, ofPixels& result) {
+    if(isLumaFormat(source.getPixelFormat())) {
+        remapLuma(source, region, color1, color2, result);
+        return;
+    }
+
+    source.cropTo(result, region.x, region.y, region.width, region.height);
+
+    size_t channels = result.getNumChannels();
+    if(channels < 3) return;
+
+    for(size_t i = 0; i < result.size(); i += channels) {
+        float r = result[i];
+        float g = result[i + 1];
+        float b = result[i + 2];
+
+        // Calculate brightness using perceived luminance weights
+        float brightness = (0.299f * r + 0.587f * g + 0.114f * b) / 255.0f;
+
+        // Interpolate between colors based on brightness
+        ofColor mapped = color1.getLerped(color2, brightness);
+
+        result[i] = mapped.r;
+        result[i + 1] = mapped.g;
+        result[i + 2] = mapped.b;
+    }
+}
+
+void ColorRemap::remapLuma(const ofPixels& source, const ofRectangle& region,
+                           const ofColor& color1, const ofColor& color2, ofPixels& result) {
+    // The Y plane comes first and is one byte per pixel, tightly packed
+    int sourceWidth = source.getWidth();
+    int sourceHeight = source.getHeight();
+    int x0 = ofClamp(region.x, 0, sourceWidth);
+    int y0 = ofClamp(region.y, 0, sourceHeight);
+    int width = min<int>(region.width, sourceWidth - x0);
+    int height = min<int>(region.height, sourceHeight - y0);
+    if(width <= 0 || height <= 0) {
+        result.clear();
+        return;
+    }
+
+    // One color per luma value; video range levels are stretched to full range
+    bool videoRange = source.getPixelFormat() != OF_PIXELS_GRAY && source.getPixelFormat() != OF_PIXELS_Y;
+    unsigned char table[256][3];
+    for(int v = 0; v < 256; v++) {
+        float brightness = videoRange ? ofClamp((v - 16) / 219.0f, 0, 1) : v / 255.0f;
+        ofColor mapped = color1.getLerped(color2, brightness);
+        table[v][0] = mapped.r;
+        table[v][1] = mapped.g;
+        table[v][2] = mapped.b;
+    }
+
+    result.allocate(width, height, OF_PIXELS_RGB);
+    const unsigned char* luma = source.getData();
+    unsigned char* out = result.getData();
+    for(int y = 0; y < height; y++) {
+        const unsigned char* row = luma + size_t(y0 + y) * sourceWidth + x0;
+        for(int x = 0; x < width; x++) {
+            const unsigned char* color = table[row[x]];
+            out[0] = color[0];
+            out[1] = color[1];
+            out[2] = color[2];
+            out += 3;
+        }
+    }
+}
+
+void ColorRemap::applyGradient(ofPixels& pixels, const ofPixels& gradient, float strength) {
+    if(!gradient.isAllocated() || strength <= 0) return;
+
+    size_t channels = pixels.getNumChannels();
+    if(channels < 3) return;
+
+    // Nearest gradient texel for each pixel, same as drawing it over the tile
+    float scaleX = gradient.getWidth() / float(pixels.getWidth());
+    float scaleY = gradient.getHeight() / float(pixels.getHeight());
+    for(size_t y = 0; y < pixels.getHeight(); y++) {
+        size_t gy = min<size_t>(y * scaleY, gradient.getHeight() - 1);
+        for(size_t x = 0; x < pixels.getWidth(); x++) {
+            size_t gx = min<size_t>(x * scaleX, gradient.getWidth() - 1);
+            ofColor g = gradient.getColor(gx, gy);
+            float alpha = g.a / 255.0f * strength;
+
+            size_t i = (y * pixels.getWidth() + x) * channels;
+            pixels[i] = pixels[i] + (g.r - pixels[i]) * alpha;
+            pixels[i + 1] = pixels[i + 1] + (g.g - pixels[i + 1]) * alpha;
+            pixels[i + 2] = pixels[i + 2] + (g.b - pixels[i + 2]) * alpha;
+        }
+    }
+}
+
+bool ColorRemap::setup() {
+    bool programmable = ofIsGLProgrammableRenderer();
+    string version = programmable ? "#version 150\n"
+                                  : "#version 120\n#extension GL_ARB_texture_rectangle : enable\n";
+
+    auto build = [&](ofShader& shader, bool rectangle) {
+        string defines = rectangle
+            ? "#define SAMPLER sampler2DRect\n#define TEXTURE texture2DRect\n"
+            : "#define SAMPLER sampler2D\n#define TEXTURE texture2D\n";
+        string fragment = version + defines + (programmable ? FRAGMENT_BODY_GL3 : FRAGMENT_BODY_GL2);
+
+        if(!shader.setupShaderFromSource(GL_VERTEX_SHADER, programmable ? VERTEX_GL3 : VERTEX_GL2)) return false;
+        if(!shader.setupShaderFromSource(GL_FRAGMENT_SHADER, fragment)) return false;
+        if(programmable) shader.bindDefaults();
+        return shader.linkProgram();
+    };
+
+    shaderAvailable = build(rectShader, true) && build(shader2D, false);
+    if(shaderAvailable) {
+        ofLog() << "Color remap shader ready";
+    } else {
+        ofLog() << "Color remap shader unavailable, using CPU remap";
+    }
+    return shaderAvailable;
+}
+
+void ColorRemap::updatePalette(const vector<ofColor>& colors) {
+    if(!shaderAvailable || colors.empty() || colors == paletteColors) return;
+
+    paletteColors = colors;
+    ofPixels pixels;
+    pixels.allocate(colors.size(), 1, OF_PIXELS_RGBA);
+    for(size_t i = 0; i < colors.size(); i++) {
+        pixels.setColor(i, 0, colors[i]);
+    }
+
+    // Normalized coordinates and nearest filtering, one texel per swatch
+    if(!paletteTexture.isAllocated() || paletteTexture.getWidth() != colors.size()) {
+        paletteTexture.allocate(colors.size(), 1, GL_RGBA8, false);
+        paletteTexture.setTextureMinMagFilter(GL_NEAREST, GL_NEAREST);
+    }
+    paletteTexture.loadData(pixels);
+}
+
+const ofShader& ColorRemap::getShader(const ofTexture& source) {
+    return source.getTextureData().textureTarget == GL_TEXTURE_2D ? shader2D : rectShader;
+}
+
+void ColorRemap::drawSubsection(const ofTexture& source, const ofRectangle& target,
+                                const ofRectangle& region, int colorIndex1, int colorIndex2) {
+    const ofShader& shader = getShader(source);
+    shader.begin();
+    shader.setUniformTexture("source", source, 0);
+    shader.setUniformTexture("palette", paletteTexture, 1);
+    shader.setUniform1f("paletteSize", paletteColors.size());
+    shader.setUniform1f("color1", colorIndex1);
+    shader.setUniform1f("color2", colorIndex2);
+    source.drawSubsection(target.x, target.y, target.width, target.height,
+                          region.x, region.y, region.width, region.height);
+    shader.end();
+}
+
+int ColorRemap::compareWithReference(const ofTexture& source, const ofPixels& sourcePixels,
+                                     const ofRectangle& region, const vector<ofColor>& colors,
+                                     int colorIndex1, int colorIndex2) {
+    if(!shaderAvailable || !source.isAllocated() || !sourcePixels.isAllocated() ||
+       colors.size() <= max(colorIndex1, colorIndex2)) {
+        return -1;
+    }
+    updatePalette(colors);
+
+    // Render the region 1:1 through the shader and read it back
+    int width = region.width;
+    int height = region.height;
+    ofFbo fbo;
+    fbo.allocate(width, height, GL_RGBA);
+    fbo.begin();
+    ofClear(0, 0, 0, 255);
+    ofSetColor(255);
+    drawSubsection(source, ofRectangle(0, 0, width, height), region, colorIndex1, colorIndex2);
+    fbo.end();
+
+    ofPixels gpuPixels;
+    fbo.readToPixels(gpuPixels);
+
+    ofPixels cpuPixels;
+    remapToPalette(sourcePixels, region, colors[colorIndex1], colors[colorIndex2], cpuPixels);
+
+    int maxDifference = 0;
+    for(int y = 0; y < height; y++) {
+        for(int x = 0; x < width; x++) {
+            ofColor gpu = gpuPixels.getColor(x, y);
+            ofColor cpu = cpuPixels.getColor(x, y);
+            for(int c = 0; c < 3; c++) {
+                maxDifference = max(maxDifference, abs(int(gpu[c]) - int(cpu[c])));
+            }
+        }
+    }
+    return maxDifference;
+}
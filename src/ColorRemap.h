@@ -0,0 +1,56 @@
+#pragma once
+#include "ofMain.h"
+
+// Two-color brightness remap used by color-input tiles. Each pixel's luma
+// picks a point between two palette swatches.
+//
+// remapToPalette() is the CPU reference kernel. The shader path does the
+// same work in the fragment shader, reading the swatches from a small
+// palette texture, so color-input tiles draw straight from the source
+// texture with no CPU pixel work or uploads.
+//
+// Sources decoded to their Y plane only (see isLumaFormat) skip the luma
+// weights on the CPU path: the Y value indexes a 256-entry color table.
+class ColorRemap {
+public:
+    // CPU reference kernel, writes an RGB image the size of the region.
+    // Reads luma straight from the Y plane of planar YUV and gray sources.
+    static void remapToPalette(const ofPixels& source, const ofRectangle& region,
+                               const ofColor& color1, const ofColor& color2, ofPixels& result);
+
+    // Formats whose first plane is luma. Planar YUV is video range (16-235),
+    // gray is full range.
+    static bool isLumaFormat(ofPixelFormat format);
+
+    // Blends the gradient overlay into remapped pixels, stretched to cover them
+    static void applyGradient(ofPixels& pixels, const ofPixels& gradient, float strength);
+
+    // Shader path
+    static bool setup();
+    static bool isShaderAvailable() { return shaderAvailable; }
+    static bool isShaderEnabled() { return shaderAvailable && useShader; }
+    static void setShaderEnabled(bool enabled) { useShader = enabled; }
+    static void updatePalette(const vector<ofColor>& colors);
+    static const ofTexture& getPaletteTexture() { return paletteTexture; }
+    static size_t getPaletteSize() { return paletteColors.size(); }
+    static void drawSubsection(const ofTexture& source, const ofRectangle& target,
+                               const ofRectangle& region, int colorIndex1, int colorIndex2);
+
+    // Renders a region through the shader and returns the largest channel
+    // difference from the CPU kernel, or -1 if the shader is not available
+    static int compareWithReference(const ofTexture& source, const ofPixels& sourcePixels,
+                                    const ofRectangle& region, const vector<ofColor>& colors,
+                                    int colorIndex1, int colorIndex2);
+
+private:
+    static void remapLuma(const ofPixels& source, const ofRectangle& region,
+                          const ofColor& color1, const ofColor& color2, ofPixels& result);
+    static const ofShader& getShader(const ofTexture& source);
+
+    static ofShader rectShader;     // sources in rectangle textures
+    static ofShader shader2D;       // sources in normalized 2D textures
+    static ofTexture paletteTexture;
+    static vector<ofColor> paletteColors;
+    static bool shaderAvailable;
+    static bool useShader;
+};
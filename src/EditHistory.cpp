@@ -0,0 +1,349 @@
+#include "EditHistory.h"
+#include "ofApp.h"
+
+//--------------------------------------------------------------
+// Helpers over the three tile vectors, which share one global index space
+// (video tiles, then image tiles, then camera tiles)
+
+static TileKind getKind(const ofApp& app, int index, size_t& localIndex) {
+    size_t videoTilesEnd = app.tiles.size();
+    size_t imageTilesEnd = videoTilesEnd + app.imageTiles.size();
+    if(index < videoTilesEnd) {
+        localIndex = index;
+        return TileKind::VIDEO;
+    } else if(index < imageTilesEnd) {
+        localIndex = index - videoTilesEnd;
+        return TileKind::IMAGE;
+    }
+    localIndex = index - imageTilesEnd;
+    return TileKind::CAMERA;
+}
+
+static size_t* getSourceIndex(ofApp& app, int index) {
+    size_t localIndex;
+    switch(getKind(app, index, localIndex)) {
+        case TileKind::VIDEO: return &app.tiles[localIndex].videoIndex;
+        case TileKind::IMAGE: return &app.imageTiles[localIndex].imageIndex;
+        case TileKind::CAMERA:
+            if(localIndex < app.cameraTiles.size()) return &app.cameraTiles[localIndex].cameraIndex;
+    }
+    return nullptr;
+}
+
+template<typename T>
+static void takeTiles(vector<T>& tiles, size_t first, size_t count, vector<unique_ptr<BaseElement>>& out) {
+    count = min(count, tiles.size() - min(first, tiles.size()));
+    for(size_t i = 0; i < count; i++) {
+        out.push_back(make_unique<T>(tiles[first + i]));
+    }
+    tiles.erase(tiles.begin() + first, tiles.begin() + first + count);
+}
+
+template<typename T>
+static void putTiles(vector<T>& tiles, size_t first, vector<unique_ptr<BaseElement>>& in) {
+    first = min(first, tiles.size());
+    for(size_t i = 0; i < in.size(); i++) {
+        tiles.insert(tiles.begin() + first + i, static_cast<T&>(*in[i]));
+    }
+    in.clear();
+}
+
+static void takeTiles(ofApp& app, TileKind kind, size_t first, size_t count, vector<unique_ptr<BaseElement>>& out) {
+    switch(kind) {
+        case TileKind::VIDEO: takeTiles(app.tiles, first, count, out); break;
+        case TileKind::IMAGE: takeTiles(app.imageTiles, first, count, out); break;
+        case TileKind::CAMERA: takeTiles(app.cameraTiles, first, count, out); break;
+    }
+}
+
+static void putTiles(ofApp& app, TileKind kind, size_t first, vector<unique_ptr<BaseElement>>& in) {
+    switch(kind) {
+        case TileKind::VIDEO: putTiles(app.tiles, first, in); break;
+        case TileKind::IMAGE: putTiles(app.imageTiles, first, in); break;
+        case TileKind::CAMERA: putTiles(app.cameraTiles, first, in); break;
+    }
+}
+
+static size_t getKindStart(const ofApp& app, TileKind kind) {
+    switch(kind) {
+        case TileKind::VIDEO: return 0;
+        case TileKind::IMAGE: return app.tiles.size();
+        case TileKind::CAMERA: return app.tiles.size() + app.imageTiles.size();
+    }
+    return 0;
+}
+
+static size_t getTileByteSize(TileKind kind, const BaseElement& tile) {
+    size_t size = kind == TileKind::VIDEO ? sizeof(VideoElement)
+                : kind == TileKind::IMAGE ? sizeof(ImageElement) : sizeof(CameraElement);
+    return size + tile.getPath().capacity();
+}
+
+//--------------------------------------------------------------
+static vector<TileSpan> makeSpans(vector<int> indices) {
+    sort(indices.begin(), indices.end());
+    vector<TileSpan> spans;
+    for(int index : indices) {
+        if(!spans.empty() && spans.back().first + spans.back().count == index) {
+            spans.back().count++;
+        } else if(spans.empty() || spans.back().first + spans.back().count < index) {
+            spans.push_back({index, 1});
+        }
+    }
+    return spans;
+}
+
+MoveTilesCommand::MoveTilesCommand(const vector<int>& indices, float dx, float dy)
+    : spans(makeSpans(indices)), offset(dx, dy) {
+}
+
+MoveTilesCommand::MoveTilesCommand(const vector<int>& indices, const vector<glm::vec2>& tileOffsets)
+    : offset(0, 0) {
+    // Offsets follow the span order, which is sorted by index
+    vector<pair<int, glm::vec2>> sorted;
+    for(size_t i = 0; i < indices.size() && i < tileOffsets.size(); i++) {
+        sorted.emplace_back(indices[i], tileOffsets[i]);
+    }
+    sort(sorted.begin(), sorted.end(), [](const pair<int, glm::vec2>& a, const pair<int, glm::vec2>& b) {
+        return a.first < b.first;
+    });
+    vector<int> sortedIndices;
+    for(const auto& entry : sorted) {
+        sortedIndices.push_back(entry.first);
+        offsets.push_back(entry.second);
+    }
+    spans = makeSpans(sortedIndices);
+}
+
+void MoveTilesCommand::apply(ofApp& app, float sign) const {
+    size_t i = 0;
+    for(const auto& span : spans) {
+        for(int index = span.first; index < span.first + span.count; index++, i++) {
+            glm::vec2 delta = offsets.empty() ? offset : offsets[i];
+            app.offsetTile(index, delta.x * sign, delta.y * sign);
+        }
+    }
+}
+
+size_t MoveTilesCommand::getByteSize() const {
+    return sizeof(*this) + spans.capacity() * sizeof(TileSpan) + offsets.capacity() * sizeof(glm::vec2);
+}
+
+bool MoveTilesCommand::merge(const EditCommand& next) {
+    auto move = dynamic_cast<const MoveTilesCommand*>(&next);
+    if(!move || !offsets.empty() || !move->offsets.empty() || move->spans != spans) return false;
+    offset += move->offset;
+    return true;
+}
+
+//--------------------------------------------------------------
+DeleteTileCommand::DeleteTileCommand(ofApp& app, int index) : index(index) {
+    size_t localIndex;
+    kind = getKind(app, index, localIndex);
+    switch(kind) {
+        case TileKind::VIDEO: tile = make_unique<VideoElement>(app.tiles[localIndex]); break;
+        case TileKind::IMAGE: tile = make_unique<ImageElement>(app.imageTiles[localIndex]); break;
+        case TileKind::CAMERA: tile = make_unique<CameraElement>(app.cameraTiles[localIndex]); break;
+    }
+}
+
+void DeleteTileCommand::undo(ofApp& app) {
+    // The tile may have been the last of its kind, in which case its index
+    // now falls in the next kind's range, so the recorded kind is used
+    vector<unique_ptr<BaseElement>> restored;
+    switch(kind) {
+        case TileKind::VIDEO: restored.push_back(make_unique<VideoElement>(static_cast<VideoElement&>(*tile))); break;
+        case TileKind::IMAGE: restored.push_back(make_unique<ImageElement>(static_cast<ImageElement&>(*tile))); break;
+        case TileKind::CAMERA: restored.push_back(make_unique<CameraElement>(static_cast<CameraElement&>(*tile))); break;
+    }
+    putTiles(app, kind, index - getKindStart(app, kind), restored);
+}
+
+void DeleteTileCommand::redo(ofApp& app) {
+    vector<unique_ptr<BaseElement>> unused;
+    takeTiles(app, kind, index - getKindStart(app, kind), 1, unused);
+}
+
+size_t DeleteTileCommand::getByteSize() const {
+    return sizeof(*this) + getTileByteSize(kind, *tile);
+}
+
+//--------------------------------------------------------------
+void AddTilesCommand::undo(ofApp& app) {
+    takeTiles(app, kind, first, count, removed);
+}
+
+void AddTilesCommand::redo(ofApp& app) {
+    putTiles(app, kind, first, removed);
+    removed.shrink_to_fit();
+}
+
+size_t AddTilesCommand::getByteSize() const {
+    size_t bytes = sizeof(*this) + removed.capacity() * sizeof(removed[0]);
+    for(const auto& tile : removed) {
+        bytes += getTileByteSize(kind, *tile);
+    }
+    return bytes;
+}
+
+//--------------------------------------------------------------
+vector<TileState> TilePropertiesCommand::capture(ofApp& app, const vector<int>& indices) {
+    vector<TileState> states;
+    states.reserve(indices.size());
+    for(int index : indices) {
+        BaseElement* tile = app.getTile(index);
+        if(!tile) continue;
+
+        TileState state;
+        state.index = index;
+        state.colorInput = tile->hasColorInput();
+        state.colorIndex1 = tile->getColorIndex1();
+        state.colorIndex2 = tile->getColorIndex2();
+        state.primary = tile->isPrimary();
+        state.output = tile->getOutput();
+        state.size = tile->getTileSize();
+        for(int corner = 0; corner < 4; corner++) {
+            state.corners[corner] = tile->getCornerOffset(corner);
+        }
+        state.perspective = tile->hasPerspectiveWarp();
+        state.sourceIndex = *getSourceIndex(app, index);
+        state.path = tile->getPath();
+        states.push_back(state);
+    }
+    return states;
+}
+
+TilePropertiesCommand::TilePropertiesCommand(const string& name, const vector<TileState>& beforeStates,
+                                             const vector<TileState>& afterStates) : name(name) {
+    for(size_t i = 0; i < beforeStates.size() && i < afterStates.size(); i++) {
+        if(beforeStates[i] != afterStates[i]) {
+            before.push_back(beforeStates[i]);
+            after.push_back(afterStates[i]);
+        }
+    }
+}
+
+void TilePropertiesCommand::apply(ofApp& app, const vector<TileState>& states) {
+    for(const auto& state : states) {
+        BaseElement* tile = app.getTile(state.index);
+        if(!tile) continue;
+
+        tile->setColorInput(state.colorInput);
+        tile->setColorIndices(state.colorIndex1, state.colorIndex2);
+        tile->setPrimary(state.primary);
+        tile->setOutput(state.output);
+        tile->setTileSize(state.size);
+        for(int corner = 0; corner < 4; corner++) {
+            tile->setCornerOffset(corner, state.corners[corner]);
+        }
+        tile->setPerspectiveWarp(state.perspective);
+        tile->setPath(state.path);
+        *getSourceIndex(app, state.index) = state.sourceIndex;
+    }
+    app.updatePrimaryVideoDropdown();
+    // Tiles may have moved to another output's index, been resized or rewarped
+    app.spatialIndexDirty = true;
+}
+
+bool TilePropertiesCommand::merge(const EditCommand& next) {
+    auto properties = dynamic_cast<const TilePropertiesCommand*>(&next);
+    if(!properties || properties->name != name || properties->after.size() != after.size()) return false;
+    for(size_t i = 0; i < after.size(); i++) {
+        if(properties->after[i].index != after[i].index) return false;
+    }
+    after = properties->after;
+    return true;
+}
+
+size_t TilePropertiesCommand::getByteSize() const {
+    size_t bytes = sizeof(*this) + name.capacity() + (before.capacity() + after.capacity()) * sizeof(TileState);
+    for(size_t i = 0; i < before.size(); i++) {
+        bytes += before[i].path.capacity() + after[i].path.capacity();
+    }
+    return bytes;
+}
+
+//--------------------------------------------------------------
+void PlaybackSettingsCommand::apply(ofApp& app, int mode, int oscType) const {
+    if(videoIndex >= app.videoPlaybackSettings.size()) return;
+    app.videoPlaybackSettings[videoIndex] = make_tuple(static_cast<APlaybackMode>(mode),
+                                                       static_cast<AOscInputType>(oscType));
+    app.updateVideoPreviewPanel();
+}
+
+//--------------------------------------------------------------
+void EditHistory::push(unique_ptr<EditCommand> command, bool canMerge) {
+    if(applying || !command) return;
+
+    float now = ofGetElapsedTimef();
+    bool recent = lastPushTime >= 0 && now - lastPushTime < MERGE_WINDOW;
+    lastPushTime = now;
+
+    redoStack.clear();
+    redoBytes = 0;
+
+    if(canMerge && recent && !undoStack.empty()) {
+        size_t previousBytes = undoStack.back()->getByteSize();
+        if(undoStack.back()->merge(*command)) {
+            undoBytes += undoStack.back()->getByteSize() - previousBytes;
+            return;
+        }
+    }
+
+    undoBytes += command->getByteSize();
+    undoStack.push_back(move(command));
+    trim();
+}
+
+EditCommand* EditHistory::undo(ofApp& app) {
+    if(undoStack.empty()) return nullptr;
+
+    unique_ptr<EditCommand> command = move(undoStack.back());
+    undoStack.pop_back();
+    undoBytes -= command->getByteSize();
+
+    applying = true;
+    command->undo(app);
+    applying = false;
+
+    // Undone adds hold their tiles now, so the size is taken again
+    redoBytes += command->getByteSize();
+    redoStack.push_back(move(command));
+    lastPushTime = -1;
+    trim();
+    return redoStack.back().get();
+}
+
+EditCommand* EditHistory::redo(ofApp& app) {
+    if(redoStack.empty()) return nullptr;
+
+    unique_ptr<EditCommand> command = move(redoStack.back());
+    redoStack.pop_back();
+    redoBytes -= command->getByteSize();
+
+    applying = true;
+    command->redo(app);
+    applying = false;
+
+    undoBytes += command->getByteSize();
+    undoStack.push_back(move(command));
+    lastPushTime = -1;
+    trim();
+    return undoStack.back().get();
+}
+
+void EditHistory::clear() {
+    undoStack.clear();
+    redoStack.clear();
+    undoBytes = 0;
+    redoBytes = 0;
+    lastPushTime = -1;
+}
+
+void EditHistory::trim() {
+    // Oldest edits go first; the newest undo step is always kept
+    while(undoBytes + redoBytes > byteBudget && undoStack.size() > 1) {
+        undoBytes -= undoStack.front()->getByteSize();
+        undoStack.pop_front();
+    }
+}
@@ -0,0 +1,198 @@
+#pragma once
+#include "ofMain.h"
+
+class ofApp;
+class BaseElement;
+
+enum class TileKind {
+    VIDEO,
+    IMAGE,
+    CAMERA
+};
+
+// One undoable edit. Commands are recorded after the edit has been applied
+// and keep only what is needed to reverse and replay it.
+class EditCommand {
+public:
+    virtual ~EditCommand() = default;
+    virtual string getName() const = 0;
+    virtual void undo(ofApp& app) = 0;
+    virtual void redo(ofApp& app) = 0;
+    virtual size_t getByteSize() const = 0;
+
+    // Folds the following command into this one, used for held-key nudges
+    virtual bool merge(const EditCommand& next) { return false; }
+
+    // Tiles were added or removed, so indices and caches must be rebuilt
+    virtual bool isStructural() const { return false; }
+};
+
+// Run of consecutive global tile indices
+struct TileSpan {
+    int first;
+    int count;
+    bool operator==(const TileSpan& other) const { return first == other.first && count == other.count; }
+};
+
+// Moves stored as tile spans and one shared offset, or one offset per tile
+// when the tiles moved by different amounts (grid alignment)
+class MoveTilesCommand : public EditCommand {
+public:
+    MoveTilesCommand(const vector<int>& indices, float dx, float dy);
+    MoveTilesCommand(const vector<int>& indices, const vector<glm::vec2>& offsets);
+
+    string getName() const override { return "move"; }
+    void undo(ofApp& app) override { apply(app, -1); }
+    void redo(ofApp& app) override { apply(app, 1); }
+    size_t getByteSize() const override;
+    bool merge(const EditCommand& next) override;
+
+private:
+    void apply(ofApp& app, float sign) const;
+
+    vector<TileSpan> spans;
+    glm::vec2 offset;
+    vector<glm::vec2> offsets;  // empty when every tile shares offset
+};
+
+// Removal of one tile, with a copy of it to put back
+class DeleteTileCommand : public EditCommand {
+public:
+    DeleteTileCommand(ofApp& app, int index);
+
+    string getName() const override { return "delete"; }
+    void undo(ofApp& app) override;
+    void redo(ofApp& app) override;
+    size_t getByteSize() const override;
+    bool isStructural() const override { return true; }
+
+private:
+    int index;
+    TileKind kind;
+    unique_ptr<BaseElement> tile;
+};
+
+// Tiles appended for a newly loaded source. The source stays loaded when
+// the add is undone, so redo only puts the tiles back.
+class AddTilesCommand : public EditCommand {
+public:
+    AddTilesCommand(TileKind kind, size_t first, size_t count)
+        : kind(kind), first(first), count(count) {}
+
+    string getName() const override { return "add tiles"; }
+    void undo(ofApp& app) override;
+    void redo(ofApp& app) override;
+    size_t getByteSize() const override;
+    bool isStructural() const override { return true; }
+
+private:
+    TileKind kind;
+    size_t first;
+    size_t count;
+    vector<unique_ptr<BaseElement>> removed;  // held while undone
+};
+
+// Per-tile settings before and after an edit: color input, swatch indices,
+// primary flag and source
+struct TileState {
+    int index = -1;
+    bool colorInput = false;
+    int colorIndex1 = 0;
+    int colorIndex2 = 1;
+    bool primary = false;
+    int output = 0;
+    float size = 0;
+    array<glm::vec2, 4> corners = {{glm::vec2(0), glm::vec2(0), glm::vec2(0), glm::vec2(0)}};
+    bool perspective = false;
+    size_t sourceIndex = 0;
+    string path;
+
+    bool operator==(const TileState& other) const {
+        return index == other.index && colorInput == other.colorInput &&
+               colorIndex1 == other.colorIndex1 && colorIndex2 == other.colorIndex2 &&
+               primary == other.primary && output == other.output && size == other.size && corners == other.corners &&
+               perspective == other.perspective && sourceIndex == other.sourceIndex && path == other.path;
+    }
+    bool operator!=(const TileState& other) const { return !(*this == other); }
+};
+
+class TilePropertiesCommand : public EditCommand {
+public:
+    static vector<TileState> capture(ofApp& app, const vector<int>& indices);
+
+    // Keeps only the tiles that changed; empty() means nothing to record
+    TilePropertiesCommand(const string& name, const vector<TileState>& before, const vector<TileState>& after);
+    bool empty() const { return before.empty(); }
+
+    string getName() const override { return name; }
+    void undo(ofApp& app) override { apply(app, before); }
+    void redo(ofApp& app) override { apply(app, after); }
+    size_t getByteSize() const override;
+    // Same edit on the same tiles: keeps the first before and the last after
+    bool merge(const EditCommand& next) override;
+
+private:
+    static void apply(ofApp& app, const vector<TileState>& states);
+
+    string name;
+    vector<TileState> before;
+    vector<TileState> after;
+};
+
+// Loop or OSC playback and the OSC axis of one video
+class PlaybackSettingsCommand : public EditCommand {
+public:
+    PlaybackSettingsCommand(size_t videoIndex, int modeBefore, int oscBefore, int modeAfter, int oscAfter)
+        : videoIndex(videoIndex), modeBefore(modeBefore), oscBefore(oscBefore),
+          modeAfter(modeAfter), oscAfter(oscAfter) {}
+
+    string getName() const override { return "playback"; }
+    void undo(ofApp& app) override { apply(app, modeBefore, oscBefore); }
+    void redo(ofApp& app) override { apply(app, modeAfter, oscAfter); }
+    size_t getByteSize() const override { return sizeof(*this); }
+
+private:
+    void apply(ofApp& app, int mode, int oscType) const;
+
+    size_t videoIndex;
+    int modeBefore, oscBefore;
+    int modeAfter, oscAfter;
+};
+
+// Undo and redo stacks bounded by the bytes their commands hold rather than
+// by entry count, so a long run of small nudges costs the same as a few
+// large deletes.
+class EditHistory {
+public:
+    explicit EditHistory(size_t byteBudget = 1024 * 1024) : byteBudget(byteBudget) {}
+
+    // Records an applied edit and drops the redo stack. With canMerge, an
+    // edit within MERGE_WINDOW of the previous one may be folded into it.
+    void push(unique_ptr<EditCommand> command, bool canMerge = false);
+
+    // Return the command that was reversed or replayed, or nullptr
+    EditCommand* undo(ofApp& app);
+    EditCommand* redo(ofApp& app);
+    void clear();
+
+    // True while a command is being undone or redone; edits made by the
+    // command itself are not recorded
+    bool isApplying() const { return applying; }
+
+    bool canUndo() const { return !undoStack.empty(); }
+    bool canRedo() const { return !redoStack.empty(); }
+    size_t getByteSize() const { return undoBytes + redoBytes; }
+
+    static constexpr float MERGE_WINDOW = 0.5f;  // seconds
+
+private:
+    void trim();
+
+    deque<unique_ptr<EditCommand>> undoStack;
+    vector<unique_ptr<EditCommand>> redoStack;
+    size_t undoBytes = 0;
+    size_t redoBytes = 0;
+    size_t byteBudget;
+    float lastPushTime = -1;
+    bool applying = false;
+};
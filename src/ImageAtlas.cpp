@@ -0,0 +1,219 @@
+#include "ImageAtlas.h"
+#include "ResourceTracker.h"
+
+static ofPoint getPaddedSize(const ofRectangle& region) {
+    return ofPoint(max(1, int(region.width)) + ImageAtlas::PADDING * 2,
+                   max(1, int(region.height)) + ImageAtlas::PADDING * 2);
+}
+
+void ImageAtlas::update(vector<TiledImage>& images, const vector<pair<size_t, ofRectangle>>& regions) {
+    // Regions drawn now, and those of them not placed yet
+    set<Key> drawn;
+    vector<pair<size_t, ofRectangle>> wanted;
+    vector<pair<size_t, ofRectangle>> missing;
+    for(const auto& entry : regions) {
+        if(entry.first >= images.size() || !images[entry.first].isAllocated()) continue;
+        if(!drawn.insert(makeKey(entry.first, entry.second)).second) continue;
+        // Too large for any page, always drawn from its own texture
+        ofPoint size = getPaddedSize(entry.second);
+        if(size.x > PAGE_SIZE || size.y > PAGE_SIZE) continue;
+        wanted.push_back(entry);
+        if(!placements.count(makeKey(entry.first, entry.second))) {
+            missing.push_back(entry);
+        }
+    }
+    if(missing.empty()) return;
+
+    // Tallest first packs a skyline tighter
+    auto byHeight = [](const pair<size_t, ofRectangle>& a, const pair<size_t, ofRectangle>& b) {
+        return a.second.height > b.second.height;
+    };
+    sort(missing.begin(), missing.end(), byHeight);
+    bool allPlaced = insert(images, missing, false);
+
+    // Out of room while regions nobody draws hold space, or on pages that
+    // could be larger: start over with only the drawn ones, on full pages
+    size_t unused = placements.size() - (wanted.size() - missing.size());
+    bool smallPages = false;
+    for(const auto& page : pages) {
+        smallPages = smallPages || page.size < PAGE_SIZE;
+    }
+    if(!allPlaced && (unused > 0 || smallPages)) {
+        clear();
+        sort(wanted.begin(), wanted.end(), byHeight);
+        insert(images, wanted, true);
+    }
+    ofLog() << "Image atlas: " << placements.size() << " regions on " << pages.size() << " pages";
+}
+
+void ImageAtlas::clear() {
+    pages.clear();
+    placements.clear();
+}
+
+const ofTexture* ImageAtlas::find(size_t imageIndex, const ofRectangle& region, ofRectangle& atlasRegion) const {
+    auto it = placements.find(makeKey(imageIndex, region));
+    if(it == placements.end()) return nullptr;
+    atlasRegion = it->second.rect;
+    return &pages[it->second.page].texture;
+}
+
+ImageAtlas::Key ImageAtlas::makeKey(size_t imageIndex, const ofRectangle& region) {
+    return make_tuple(imageIndex, int(region.x), int(region.y), int(region.width), int(region.height));
+}
+
+bool ImageAtlas::insert(vector<TiledImage>& images, const vector<pair<size_t, ofRectangle>>& regions, bool fullPages) {
+    uint64_t areaLeft = 0;
+    for(const auto& entry : regions) {
+        ofPoint size = getPaddedSize(entry.second);
+        areaLeft += uint64_t(size.x) * size.y;
+    }
+    
+    bool allPlaced = true;
+    for(const auto& entry : regions) {
+        ofPoint size = getPaddedSize(entry.second);
+        Placement placement;
+        bool placed = place(size.x, size.y, areaLeft, fullPages, placement);
+        areaLeft -= uint64_t(size.x) * size.y;
+        if(!placed) {
+            allPlaced = false;
+            continue;
+        }
+        upload(images[entry.first], entry.second, placement);
+        placements[makeKey(entry.first, entry.second)] = placement;
+    }
+    return allPlaced;
+}
+
+int ImageAtlas::getPageSize(uint64_t area, int width, int height) {
+    // A quarter more than the area, for what the skyline leaves empty
+    int size = MIN_PAGE_SIZE;
+    while(size < PAGE_SIZE && (size < width || size < height || uint64_t(size) * size < area + area / 4)) {
+        size *= 2;
+    }
+    return min(size, int(PAGE_SIZE));
+}
+
+bool ImageAtlas::place(int width, int height, uint64_t areaLeft, bool fullPages, Placement& placement) {
+    if(width > PAGE_SIZE || height > PAGE_SIZE) return false;
+
+    for(size_t attempt = 0; attempt < 2; attempt++) {
+        // Lowest position on any page, leftmost on ties
+        int bestPage = -1;
+        size_t bestIndex = 0;
+        int bestX = 0;
+        int bestY = PAGE_SIZE;
+        for(size_t p = 0; p < pages.size(); p++) {
+            const vector<Span>& skyline = pages[p].skyline;
+            for(size_t i = 0; i < skyline.size(); i++) {
+                int y;
+                if(fits(pages[p], i, width, height, y) && (y < bestY || (y == bestY && skyline[i].x < bestX))) {
+                    bestPage = p;
+                    bestIndex = i;
+                    bestX = skyline[i].x;
+                    bestY = y;
+                }
+            }
+        }
+        if(bestPage >= 0) {
+            addToSkyline(pages[bestPage].skyline, bestIndex, bestX, bestY, width, height);
+            placement.page = bestPage;
+            placement.rect.set(bestX + PADDING, bestY + PADDING, width - PADDING * 2, height - PADDING * 2);
+            return true;
+        }
+
+        // No room anywhere, open a new page if allowed and try once more.
+        // It is sized for what is left to place, the last one is full size.
+        if(pages.size() >= MAX_PAGES) return false;
+        bool lastPage = pages.size() + 1 == MAX_PAGES;
+        int size = fullPages || lastPage ? PAGE_SIZE : getPageSize(areaLeft, width, height);
+        pages.emplace_back();
+        pages.back().size = size;
+        pages.back().texture.allocate(size, size, GL_RGBA, false);
+        pages.back().skyline.push_back({0, 0, size});
+    }
+    return false;
+}
+
+bool ImageAtlas::fits(const Page& page, size_t index, int width, int height, int& y) {
+    const vector<Span>& skyline = page.skyline;
+    if(skyline[index].x + width > page.size) return false;
+
+    // The region rests on the highest span it covers
+    y = 0;
+    int remaining = width;
+    for(size_t i = index; remaining > 0; i++) {
+        if(i == skyline.size()) return false;
+        y = max(y, skyline[i].y);
+        if(y + height > page.size) return false;
+        remaining -= skyline[i].width;
+    }
+    return true;
+}
+
+void ImageAtlas::addToSkyline(vector<Span>& skyline, size_t index, int x, int y, int width, int height) {
+    skyline.insert(skyline.begin() + index, {x, y + height, width});
+
+    // Cut the spans now covered by the new one
+    int right = x + width;
+    for(size_t i = index + 1; i < skyline.size(); ) {
+        if(skyline[i].x >= right) break;
+        int overlap = right - skyline[i].x;
+        skyline[i].x += overlap;
+        skyline[i].width -= overlap;
+        if(skyline[i].width > 0) break;
+        skyline.erase(skyline.begin() + i);
+    }
+
+    // Neighbouring spans at the same height become one
+    for(size_t i = 0; i + 1 < skyline.size(); ) {
+        if(skyline[i].y == skyline[i + 1].y) {
+            skyline[i].width += skyline[i + 1].width;
+            skyline.erase(skyline.begin() + i + 1);
+        } else {
+            i++;
+        }
+    }
+}
+
+void ImageAtlas::upload(const TiledImage& image, const ofRectangle& region, const Placement& placement) {
+    ofPixels pixels;
+    image.getRegionPixels(region, pixels);
+    if(pixels.getNumChannels() != 4) {
+        pixels.setImageType(OF_IMAGE_COLOR_ALPHA);
+    }
+
+    // Edge pixels are repeated into the padding so filtering never reads a neighbour
+    int width = pixels.getWidth();
+    int height = pixels.getHeight();
+    int paddedWidth = width + PADDING * 2;
+    int paddedHeight = height + PADDING * 2;
+    ofPixels padded;
+    padded.allocate(paddedWidth, paddedHeight, OF_PIXELS_RGBA);
+    for(int y = 0; y < paddedHeight; y++) {
+        int sourceY = ofClamp(y - PADDING, 0, height - 1);
+        const unsigned char* row = pixels.getData() + size_t(sourceY) * width * 4;
+        unsigned char* out = padded.getData() + size_t(y) * paddedWidth * 4;
+        for(int x = 0; x < PADDING; x++) {
+            memcpy(out + x * 4, row, 4);
+            memcpy(out + (PADDING + width + x) * 4, row + (width - 1) * 4, 4);
+        }
+        memcpy(out + PADDING * 4, row, size_t(width) * 4);
+    }
+
+    const ofTextureData& texData = pages[placement.page].texture.getTextureData();
+    glBindTexture(texData.textureTarget, texData.textureID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(texData.textureTarget, 0, placement.rect.x - PADDING, placement.rect.y - PADDING,
+                    paddedWidth, paddedHeight, GL_RGBA, GL_UNSIGNED_BYTE, padded.getData());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(texData.textureTarget, 0);
+}
+
+uint64_t ImageAtlas::getTextureBytes() const {
+    uint64_t bytes = 0;
+    for(const auto& page : pages) {
+        bytes += ResourceTracker::getBytes(page.texture);
+    }
+    return bytes;
+}
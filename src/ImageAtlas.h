@@ -0,0 +1,65 @@
+#pragma once
+#include "ofMain.h"
+#include "TiledImage.h"
+
+// Packs the image regions tiles draw into a few large textures, so a layout
+// of many small stills draws from a handful of textures instead of binding
+// one per tile.
+//
+// Regions are placed with a skyline packer and keep their place as others
+// are added. A new page is only as large as the regions still to place need.
+// Only when the pages have no room left and some regions are no longer drawn,
+// or some pages are smaller than PAGE_SIZE, is the whole atlas packed again.
+class ImageAtlas {
+public:
+    static const int PAGE_SIZE = 4096;     // largest page
+    static const int MIN_PAGE_SIZE = 256;
+    static const int MAX_PAGES = 4;
+    static const int PADDING = 1;    // edge pixels repeated around each region for filtering
+
+    // Places and uploads the regions not in the atlas yet. Regions that fit
+    // nowhere are left out and drawn from their own texture.
+    void update(vector<TiledImage>& images, const vector<pair<size_t, ofRectangle>>& regions);
+    void clear();
+
+    // Page holding an image region and the region's place on it, or nullptr
+    // if the region is not in the atlas
+    const ofTexture* find(size_t imageIndex, const ofRectangle& region, ofRectangle& atlasRegion) const;
+
+    size_t getNumPages() const { return pages.size(); }
+    size_t getNumRegions() const { return placements.size(); }
+    uint64_t getTextureBytes() const;
+
+private:
+    typedef tuple<size_t, int, int, int, int> Key;
+
+    // One step of the skyline: the top edge of what is packed below it
+    struct Span {
+        int x;
+        int y;
+        int width;
+    };
+    struct Page {
+        ofTexture texture;
+        vector<Span> skyline;
+        int size = 0;
+    };
+    struct Placement {
+        size_t page = 0;
+        ofRectangle rect;    // the region itself, inside its padding
+    };
+
+    static Key makeKey(size_t imageIndex, const ofRectangle& region);
+    static int getPageSize(uint64_t area, int width, int height);
+    static bool fits(const Page& page, size_t index, int width, int height, int& y);
+    static void addToSkyline(vector<Span>& skyline, size_t index, int x, int y, int width, int height);
+
+    // With fullPages, new pages are PAGE_SIZE whatever is left to place
+    bool insert(vector<TiledImage>& images, const vector<pair<size_t, ofRectangle>>& regions, bool fullPages);
+    // areaLeft is the padded area of this region and those placed after it
+    bool place(int width, int height, uint64_t areaLeft, bool fullPages, Placement& placement);
+    void upload(const TiledImage& image, const ofRectangle& region, const Placement& placement);
+
+    vector<Page> pages;
+    map<Key, Placement> placements;
+};
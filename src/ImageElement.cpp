@@ -1,4 +1,6 @@
 #include "ImageElement.h"
+#include "ColorRemap.h"
+#include "Profiler.h"
 
 ImageElement::ImageElement() {
     offsetX = offsetY = 0;
@@ -6,110 +8,120 @@ ImageElement::ImageElement() {
     imageIndex = 0;
 }
 
-void ImageElement::draw(const vector<ofImage>& images, const vector<ofColor>& colorSwatches, 
-                       bool showGui, size_t tileIndex) const {
+void ImageElement::draw(vector<TiledImage>& images, const ImageAtlas& atlas,
+                        const vector<ofColor>& colorSwatches) const {
+    PROFILE_SCOPE("tile draw");
     if(isLoaded && imageIndex < images.size()) {
-        const auto& image = images[imageIndex];
+        auto& image = images[imageIndex];
+        ofRectangle target = getTargetRect();
         
-        if(useColorInput && !isPrimaryElement && colorSwatches.size() > max(colorIndex1, colorIndex2)) {
-            // Get the image region
-            ofPixels imagePixels = image.getPixels();
-            ofPixels pixels;
-            pixels.allocate(sourceRegion.width, sourceRegion.height, OF_PIXELS_RGB);
+        if(usesColorInput(colorSwatches) && ColorRemap::isShaderEnabled()) {
+            // Remap on the GPU straight from the source texture
+            ofRectangle region;
+            const ofTexture& texture = getSourceTexture(image, atlas, region);
+            ColorRemap::drawSubsection(texture, target, region, colorIndex1, colorIndex2);
+            drawGradient(target);
             
-            // Copy the region manually
-            for(int y = 0; y < sourceRegion.height; y++) {
-                for(int x = 0; x < sourceRegion.width; x++) {
-                    ofColor color = imagePixels.getColor(
-                        x + sourceRegion.x, 
-                        y + sourceRegion.y
-                    );
-                    pixels.setColor(x, y, color);
-                }
-            }
-            
-            // Allocate OpenCV images if needed
-            if(!isCvImageAllocated || 
-               cvImage.getWidth() != sourceRegion.width || 
-               cvImage.getHeight() != sourceRegion.height) {
-                cvImage.clear();
-                grayImage.clear();
-                cvImage.allocate(sourceRegion.width, sourceRegion.height);
-                grayImage.allocate(sourceRegion.width, sourceRegion.height);
-                isCvImageAllocated = true;
-            }
-            
-            // Convert to grayscale using OpenCV
-            cvImage.setFromPixels(pixels);
-            grayImage = cvImage;
-            
-            // Get grayscale pixels
-            ofPixels& grayPixels = grayImage.getPixels();
-            ofPixels coloredPixels;
-            coloredPixels.allocate(sourceRegion.width, sourceRegion.height, OF_PIXELS_RGB);
-            
-            // Map grayscale values to colors
-            for(size_t y = 0; y < sourceRegion.height; y++) {
-                for(size_t x = 0; x < sourceRegion.width; x++) {
-                    float brightness = grayPixels.getColor(x, y).getBrightness() / 255.0f;
-                    ofColor mappedColor = colorSwatches[colorIndex1].getLerped(
-                        colorSwatches[colorIndex2], brightness);
-                    coloredPixels.setColor(x, y, mappedColor);
-                }
-            }
-            
-            // Draw the processed image
-            ofTexture tex;
-            tex.loadData(coloredPixels);
-            tex.draw(x + offsetX, y + offsetY, TILE_SIZE, TILE_SIZE);
+        } else if(usesColorInput(colorSwatches)) {
+            // Draw the processed image, gradient is baked in
+            remapOnCpu(image, colorSwatches).draw(target);
             
         } else {
             // Normal drawing without color replacement
-            image.getTexture().drawSubsection(
-                x + offsetX, y + offsetY, 
-                TILE_SIZE, TILE_SIZE,
-                sourceRegion.x, sourceRegion.y,
-                sourceRegion.width, sourceRegion.height
-            );
-        }
-        
-        // Draw gradient overlay if enabled
-        if(showGradient && gradientTexture.isAllocated()) {
-            ofPushStyle();
-            ofEnableAlphaBlending();
-            ofSetColor(255);
-            gradientTexture.draw(x + offsetX, y + offsetY, TILE_SIZE, TILE_SIZE);
-            ofPopStyle();
-        }
-        
-        // Draw tile index if GUI is shown
-        if(showGui) {
-            ofPushStyle();
-            float padding = 4;
-            string indexStr = ofToString(tileIndex);
-            if(isPrimaryElement) indexStr += "*";
-            
-            float textWidth = 20;
-            float textHeight = 15;
-            
-            ofSetColor(255);
-            ofDrawRectangle(x + offsetX, y + offsetY, 
-                          textWidth + padding * 2, textHeight + padding * 2);
-            
-            ofSetColor(0);
-            if(isPrimaryElement) ofSetColor(255, 0, 0);
-            ofDrawBitmapString(indexStr, 
-                             x + offsetX + padding, 
-                             y + offsetY + textHeight);
-            ofPopStyle();
+            ofRectangle region;
+            getSourceTexture(image, atlas, region).drawSubsection(target.x, target.y, target.width, target.height,
+                                                                  region.x, region.y, region.width, region.height);
+            drawGradient(target);
         }
     } else {
-        ofSetColor(40);
-        ofDrawRectangle(x + offsetX, y + offsetY, TILE_SIZE, TILE_SIZE);
-        ofSetColor(255);
+        drawPlaceholder();
     }
 }
 
+void ImageElement::addToBatch(TileRenderer& renderer, vector<TiledImage>& images, const ImageAtlas& atlas,
+                              const vector<ofColor>& colorSwatches) const {
+    PROFILE_SCOPE("tile batch");
+    if(!isLoaded || imageIndex >= images.size()) return;
+    
+    auto& image = images[imageIndex];
+    if(usesColorInput(colorSwatches) && !ColorRemap::isShaderEnabled()) {
+        const ofTexture& remapped = remapOnCpu(image, colorSwatches);
+        renderer.add(remapped, getTargetQuad(), ofRectangle(0, 0, remapped.getWidth(), remapped.getHeight()),
+                     false, 0, 0, false);
+        return;
+    }
+    
+    // Tiles on the same atlas page join one batch
+    ofRectangle region;
+    const ofTexture& texture = getSourceTexture(image, atlas, region);
+    if(usesColorInput(colorSwatches)) {
+        renderer.add(texture, getTargetQuad(), region, true, colorIndex1, colorIndex2);
+    } else {
+        renderer.add(texture, getTargetQuad(), region);
+    }
+}
+
+const ofTexture& ImageElement::getSourceTexture(TiledImage& image, const ImageAtlas& atlas,
+                                               ofRectangle& region) const {
+    const ofTexture* page = atlas.find(imageIndex, sourceRegion, region);
+    if(page) return *page;
+    
+    // Region textures stay valid until the next TiledImage::trim(), after the batch is drawn
+    const ofTexture& texture = image.getRegionTexture(sourceRegion);
+    region.set(0, 0, texture.getWidth(), texture.getHeight());
+    return texture;
+}
+
+const ofTexture& ImageElement::remapOnCpu(const TiledImage& image, const vector<ofColor>& colorSwatches) const {
+    PROFILE_SCOPE("cpu remap");
+    // Still images only need remapping again when an input to the result changes
+    RemapKey key;
+    key.imageIndex = imageIndex;
+    key.region = sourceRegion;
+    key.colorIndex1 = colorIndex1;
+    key.colorIndex2 = colorIndex2;
+    key.paletteGeneration = paletteGeneration;
+    key.gradientWeight = isGradientVisible() ? gradientStrength : 0;
+    if(remapTexture.isAllocated() && key == remapKey) return remapTexture;
+    
+    ofPixels regionPixels;
+    image.getRegionPixels(sourceRegion, regionPixels);
+    ofPixels coloredPixels;
+    ColorRemap::remapToPalette(regionPixels, ofRectangle(0, 0, regionPixels.getWidth(), regionPixels.getHeight()),
+                               colorSwatches[colorIndex1], colorSwatches[colorIndex2], coloredPixels);
+    remapKey = key;
+    return uploadRemapped(coloredPixels);
+}
+
+void ImageElement::drawLabel(size_t tileIndex) const {
+    if(!isLoaded) return;
+    
+    ofPushStyle();
+    float padding = 4;
+    string indexStr = ofToString(tileIndex);
+    if(isPrimaryElement) indexStr += "*";
+    
+    float textWidth = 20;
+    float textHeight = 15;
+    
+    ofSetColor(255);
+    ofDrawRectangle(x + offsetX, y + offsetY, 
+                  textWidth + padding * 2, textHeight + padding * 2);
+    
+    ofSetColor(0);
+    if(isPrimaryElement) ofSetColor(255, 0, 0);
+    ofDrawBitmapString(indexStr, 
+                     x + offsetX + padding, 
+                     y + offsetY + textHeight);
+    ofPopStyle();
+}
+
+void ImageElement::drawPlaceholder() const {
+    ofSetColor(40);
+    ofDrawRectangle(getTargetRect());
+    ofSetColor(255);
+}
+
 void ImageElement::setImageRegion(size_t index, const ofRectangle& region) {
     imageIndex = index;
     sourceRegion = region;
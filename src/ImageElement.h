@@ -1,5 +1,8 @@
 #pragma once
 #include "BaseElement.h"
+#include "TileRenderer.h"
+#include "TiledImage.h"
+#include "ImageAtlas.h"
 
 class ImageElement : public BaseElement {
 public:
@@ -7,12 +10,41 @@ public:
     virtual ~ImageElement() = default;
     
     // Draw function specific to ImageElement
-    void draw(const vector<ofImage>& images, const vector<ofColor>& colorSwatches, 
-             bool showGui = false, size_t tileIndex = 0) const;
+    void draw(vector<TiledImage>& images, const ImageAtlas& atlas, const vector<ofColor>& colorSwatches) const;
+    void addToBatch(TileRenderer& renderer, vector<TiledImage>& images, const ImageAtlas& atlas,
+                    const vector<ofColor>& colorSwatches) const;
+    void drawLabel(size_t tileIndex) const;
+    void drawPlaceholder() const;
              
     // Set the image region for this tile
     void setImageRegion(size_t index, const ofRectangle& region);
     
     // Image index in the images vector
     size_t imageIndex;
+    
+private:
+    struct RemapKey {
+        size_t imageIndex = 0;
+        ofRectangle region;
+        int colorIndex1 = -1;
+        int colorIndex2 = -1;
+        uint64_t paletteGeneration = 0;
+        float gradientWeight = 0;
+        
+        bool operator==(const RemapKey& other) const {
+            return imageIndex == other.imageIndex && region == other.region &&
+                   colorIndex1 == other.colorIndex1 && colorIndex2 == other.colorIndex2 &&
+                   paletteGeneration == other.paletteGeneration && gradientWeight == other.gradientWeight;
+        }
+    };
+    
+    bool usesColorInput(const vector<ofColor>& colorSwatches) const {
+        return useColorInput && !isPrimaryElement && colorSwatches.size() > max(colorIndex1, colorIndex2);
+    }
+    // The atlas page holding the source region, or else the region's own texture
+    const ofTexture& getSourceTexture(TiledImage& image, const ImageAtlas& atlas, ofRectangle& region) const;
+    const ofTexture& remapOnCpu(const TiledImage& image, const vector<ofColor>& colorSwatches) const;
+    
+    // Inputs of the remapped pixels currently in remapTexture
+    mutable RemapKey remapKey;
 }; 
\ No newline at end of file
@@ -0,0 +1,228 @@
+#include "LoopFrameCache.h"
+#include <sys/stat.h>
+
+uint64_t LoopFrameCache::diskBudgetBytes = 8ull << 30;
+
+static const char* CACHE_DIRECTORY = "cache/frames";
+static const char MAGIC[8] = {'L', 'O', 'O', 'P', 'F', 'R', 'M', '1'};
+static const int FRAME_WAIT_ATTEMPTS = 200;    // about 1 ms apart
+
+LoopFrameCache::~LoopFrameCache() {
+    close();
+}
+
+bool LoopFrameCache::open(const ofVideoPlayer& player) {
+    close();
+
+    float duration = player.getDuration();
+    int totalFrames = player.getTotalNumFrames();
+    if(duration <= 0 || duration > MAX_LOOP_SECONDS || totalFrames <= 0) return false;
+
+    // A single loop may take a quarter of the budget, leaving room for others
+    ofPixelFormat playerFormat = player.getPixelFormat();
+    uint64_t bytes = HEADER_SIZE + uint64_t(totalFrames) *
+        ofPixels::bytesFromPixelFormat(player.getWidth(), player.getHeight(), playerFormat);
+    if(bytes > diskBudgetBytes / 4) return false;
+
+    string videoPath = ofToDataPath(player.getMoviePath(), true);
+    cachePath = getCachePath(videoPath, playerFormat);
+    if(cachePath.empty()) return false;
+    if(map(cachePath)) return true;
+
+    ofLog() << "Building loop cache for " << ofFilePath::getFileName(videoPath)
+            << ", " << ofToString(bytes / (1024.0 * 1024.0), 1) << " MB";
+    builder.videoPath = videoPath;
+    builder.cachePath = cachePath;
+    builder.format = playerFormat;
+    builder.succeeded = false;
+    builder.startThread();
+    return true;
+}
+
+void LoopFrameCache::close() {
+    if(builder.isThreadRunning()) {
+        builder.waitForThread(true);
+    }
+    unmap();
+    cachePath.clear();
+}
+
+bool LoopFrameCache::update() {
+    if(!file.isOpen() && builder.succeeded && !builder.isThreadRunning()) {
+        builder.succeeded = false;
+        map(cachePath);
+    }
+    return isReady();
+}
+
+int LoopFrameCache::getFrameAt(float seconds) const {
+    if(numFrames == 0) return 0;
+    float time = fmod(seconds, getDuration());
+    if(time < 0) time += getDuration();
+    return min(int(time * frameRate), numFrames - 1);
+}
+
+const ofPixels& LoopFrameCache::getFrame(int index) {
+    index = ofClamp(index, 0, numFrames - 1);
+    // The mapping is read-only, nothing writes through these pixels
+    unsigned char* frame = const_cast<unsigned char*>(file.getData()) + HEADER_SIZE + index * frameBytes;
+    framePixels.setFromExternalPixels(frame, width, height, format);
+    return framePixels;
+}
+
+string LoopFrameCache::getCachePath(const string& videoPath, ofPixelFormat format) {
+    string name = MappedFile::getCacheName(videoPath, ofToString(int(format)));
+    if(name.empty()) return "";
+
+    ofDirectory dir(ofToDataPath(CACHE_DIRECTORY, true));
+    if(!dir.exists()) {
+        dir.create(true);
+    }
+    return ofFilePath::join(ofToDataPath(CACHE_DIRECTORY, true), name + ".frames");
+}
+
+void LoopFrameCache::enforceBudget() {
+    struct CacheFile {
+        string path;
+        uint64_t size;
+        time_t lastUsed;
+    };
+    vector<CacheFile> files;
+    uint64_t total = 0;
+
+    ofDirectory dir(ofToDataPath(CACHE_DIRECTORY, true));
+    dir.allowExt("frames");
+    dir.listDir();
+    for(size_t i = 0; i < dir.size(); i++) {
+        struct stat info;
+        string path = dir.getPath(i);
+        if(stat(path.c_str(), &info) != 0) continue;
+        files.push_back({path, uint64_t(info.st_size), info.st_mtime});
+        total += info.st_size;
+    }
+
+    // Least recently used first. Files still mapped stay readable until unmapped.
+    sort(files.begin(), files.end(), [](const CacheFile& a, const CacheFile& b) {
+        return a.lastUsed < b.lastUsed;
+    });
+    for(const auto& file : files) {
+        if(total <= diskBudgetBytes) break;
+        ofLog() << "Loop cache over budget, removing " << ofFilePath::getFileName(file.path);
+        ofFile::removeFile(file.path, false);
+        total -= file.size;
+    }
+}
+
+bool LoopFrameCache::map(const string& path) {
+    if(!file.open(path)) return false;
+
+    Header header;
+    bool valid = file.size() >= HEADER_SIZE;
+    if(valid) {
+        memcpy(&header, file.getData(), sizeof(header));
+        frameBytes = ofPixels::bytesFromPixelFormat(header.width, header.height, ofPixelFormat(header.format));
+        valid = memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 && header.numFrames > 0 && header.frameRate > 0 &&
+                HEADER_SIZE + frameBytes * header.numFrames == file.size();
+    }
+    if(!valid) {
+        ofLogWarning() << "Discarding invalid loop cache " << path;
+        file.close();
+        ofFile::removeFile(path, false);
+        return false;
+    }
+
+    // Loops are read over and over, ask the kernel to keep them resident
+    file.willNeed();
+
+    width = header.width;
+    height = header.height;
+    format = ofPixelFormat(header.format);
+    numFrames = header.numFrames;
+    frameRate = header.frameRate;
+    MappedFile::touch(path);
+    return true;
+}
+
+void LoopFrameCache::unmap() {
+    framePixels.clear();
+    file.close();
+    numFrames = 0;
+}
+
+void LoopFrameCache::Builder::threadedFunction() {
+    // Decodes on this thread only, never touching GL
+    ofVideoPlayer player;
+    player.setUseTexture(false);
+    player.setPixelFormat(format);
+    if(!player.load(videoPath)) {
+        ofLogError() << "Loop cache could not open " << videoPath;
+        return;
+    }
+
+    Header header = {};
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.width = player.getWidth();
+    header.height = player.getHeight();
+    header.format = player.getPixelFormat();
+    header.numFrames = player.getTotalNumFrames();
+    header.frameRate = header.numFrames / player.getDuration();
+    size_t frameBytes = ofPixels::bytesFromPixelFormat(header.width, header.height, ofPixelFormat(header.format));
+
+    // Written under a temporary name so a cut-short build is never mapped
+    string tempPath = cachePath + ".tmp";
+    FILE* file = fopen(tempPath.c_str(), "wb");
+    if(!file) {
+        ofLogError() << "Could not write " << tempPath;
+        return;
+    }
+    vector<char> padding(HEADER_SIZE, 0);
+    memcpy(padding.data(), &header, sizeof(header));
+    bool ok = fwrite(padding.data(), 1, HEADER_SIZE, file) == HEADER_SIZE;
+
+    // Decoded in order, one frame step at a time: seeking to every frame
+    // re-decodes from the last keyframe each time
+    player.setPaused(true);
+    player.firstFrame();
+    for(uint32_t i = 0; ok && i < header.numFrames; i++) {
+        if(!isThreadRunning()) {
+            ok = false;
+            break;
+        }
+        if(i > 0) {
+            player.nextFrame();
+        }
+        // Some backends step asynchronously. A frame that has not landed is
+        // never written, the file would keep it until the clip changes.
+        bool landed = false;
+        for(int attempt = 0; attempt < FRAME_WAIT_ATTEMPTS && isThreadRunning(); attempt++) {
+            player.update();
+            if(player.getCurrentFrame() == int(i)) {
+                landed = true;
+                break;
+            }
+            ofSleepMillis(1);
+        }
+        if(!landed) {
+            ofLogWarning() << "Loop cache: frame " << i << " of " << ofFilePath::getFileName(videoPath)
+                           << " did not decode in order, giving up";
+            ok = false;
+            break;
+        }
+        const ofPixels& pixels = player.getPixels();
+        ok = pixels.size() == frameBytes &&
+             fwrite(pixels.getData(), 1, frameBytes, file) == frameBytes;
+    }
+    ok = fclose(file) == 0 && ok;
+    player.close();
+
+    if(ok && rename(tempPath.c_str(), cachePath.c_str()) == 0) {
+        ofLog() << "Loop cache ready: " << header.numFrames << " frames of " << ofFilePath::getFileName(videoPath);
+        succeeded = true;
+        enforceBudget();
+    } else {
+        ofFile::removeFile(tempPath, false);
+        if(isThreadRunning()) {
+            ofLogError() << "Loop cache build failed for " << videoPath;
+        }
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include "ofMain.h"
+#include "MappedFile.h"
+#include <atomic>
+
+// Pre-decoded frames of a short looping clip, kept in a raw file on local
+// disk and memory mapped for playback, so a cached loop costs no decoding.
+//
+// Files live in cache/frames/ and are named by a hash of the clip's path,
+// modification time, size and pixel format, so an edited clip gets a new
+// file and the old one ages out. The first open() of a clip transcodes it
+// on a background thread; playback keeps using the decoder until the file
+// is ready. Whenever a file is written, the least recently used files are
+// removed until the directory fits the disk budget.
+//
+// Frames are stored in the decoder's format, RGB or planar YUV for luma
+// only sources, after a page-aligned header.
+class LoopFrameCache {
+public:
+    static constexpr float MAX_LOOP_SECONDS = 20;
+    static uint64_t diskBudgetBytes;     // 8 GB by default
+
+    ~LoopFrameCache();
+
+    // Starts caching the player's clip in the player's pixel format. False if
+    // it is too long or too large for the budget.
+    bool open(const ofVideoPlayer& player);
+    void close();
+
+    // Render thread: maps the file once the background build is done.
+    // Returns true while frames can be read.
+    bool update();
+    bool isReady() const { return file.isOpen(); }
+    bool isBuilding() const { return builder.isThreadRunning(); }
+    size_t getMappedBytes() const { return file.size(); }
+
+    int getNumFrames() const { return numFrames; }
+    float getDuration() const { return numFrames / frameRate; }
+    int getFrameAt(float seconds) const;
+
+    // Pixels of one frame, pointing into the read-only mapping
+    const ofPixels& getFrame(int index);
+
+private:
+    struct Header {
+        char magic[8];
+        uint32_t width;
+        uint32_t height;
+        uint32_t format;
+        uint32_t numFrames;
+        float frameRate;
+    };
+    static const size_t HEADER_SIZE = 4096;
+
+    class Builder : public ofThread {
+    public:
+        string videoPath;
+        string cachePath;
+        ofPixelFormat format;
+        std::atomic<bool> succeeded{false};
+
+    protected:
+        void threadedFunction() override;
+    };
+
+    static string getCachePath(const string& videoPath, ofPixelFormat format);
+    static void enforceBudget();
+    bool map(const string& path);
+    void unmap();
+
+    Builder builder;
+    string cachePath;
+    MappedFile file;
+    int width = 0;
+    int height = 0;
+    ofPixelFormat format = OF_PIXELS_RGB;
+    int numFrames = 0;
+    float frameRate = 30;
+    size_t frameBytes = 0;
+    ofPixels framePixels;
+};
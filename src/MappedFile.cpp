@@ -0,0 +1,67 @@
+#include "MappedFile.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if(this != &other) {
+        close();
+        data = other.data;
+        length = other.length;
+        other.data = nullptr;
+        other.length = 0;
+    }
+    return *this;
+}
+
+bool MappedFile::open(const string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0) return false;
+
+    struct stat info;
+    if(fstat(fd, &info) != 0 || info.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(mapping == MAP_FAILED) {
+        ofLogError() << "Could not map " << path;
+        return false;
+    }
+    data = static_cast<unsigned char*>(mapping);
+    length = info.st_size;
+    return true;
+}
+
+void MappedFile::close() {
+    if(data) {
+        munmap(data, length);
+        data = nullptr;
+        length = 0;
+    }
+}
+
+void MappedFile::willNeed() const {
+    if(data) {
+        madvise(data, length, MADV_WILLNEED);
+    }
+}
+
+string MappedFile::getCacheName(const string& sourcePath, const string& variant) {
+    struct stat info;
+    if(stat(sourcePath.c_str(), &info) != 0) return "";
+
+    string key = sourcePath + "|" + ofToString(int64_t(info.st_mtime)) + "|" +
+                 ofToString(int64_t(info.st_size)) + "|" + variant;
+    stringstream name;
+    name << std::hex << std::hash<string>{}(key);
+    return name.str();
+}
+
+void MappedFile::touch(const string& path) {
+    utimes(path.c_str(), nullptr);
+}
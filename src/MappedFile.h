@@ -0,0 +1,36 @@
+#pragma once
+#include "ofMain.h"
+
+// A read-only memory mapping of a file, unmapped when destroyed. Backs the
+// on-disk caches that trade a one-time decode for mapped reads.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool open(const string& path);
+    void close();
+
+    bool isOpen() const { return data != nullptr; }
+    const unsigned char* getData() const { return data; }
+    size_t size() const { return length; }
+
+    // Asks the kernel to read the whole file in ahead of use
+    void willNeed() const;
+
+    // Cache file name for a source file: a hash of its path, modification
+    // time, size and the variant, so editing the source changes the name.
+    // Empty if the source does not exist.
+    static string getCacheName(const string& sourcePath, const string& variant);
+
+    // Sets a file's modification time to now, used as its last use
+    static void touch(const string& path);
+
+private:
+    unsigned char* data = nullptr;
+    size_t length = 0;
+};
@@ -0,0 +1,136 @@
+#include "OfflineRenderer.h"
+
+bool OfflineRenderer::parseArguments(int argc, char* argv[], Settings& settings) {
+    bool render = false;
+    for(int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if(arg == "--render" && hasValue) {
+            settings.layoutPath = argv[++i];
+            render = true;
+        } else if(arg == "--verify-remap" && hasValue) {
+            settings.layoutPath = argv[++i];
+            settings.verifyRemap = true;
+            render = true;
+        } else if(arg == "--tolerance" && hasValue) {
+            settings.remapTolerance = ofToInt(argv[++i]);
+        } else if(arg == "--frames" && hasValue) {
+            settings.frames = ofToInt(argv[++i]);
+        } else if(arg == "--fps" && hasValue) {
+            settings.fps = ofToFloat(argv[++i]);
+        } else if(arg == "--out" && hasValue) {
+            settings.outputDir = argv[++i];
+        } else if(arg == "--format" && hasValue) {
+            settings.format = argv[++i];
+        } else if(arg == "--osc" && hasValue) {
+            settings.oscPath = argv[++i];
+        } else if(arg == "--size" && hasValue) {
+            vector<string> size = ofSplitString(argv[++i], "x");
+            if(size.size() == 2) {
+                settings.width = ofToInt(size[0]);
+                settings.height = ofToInt(size[1]);
+            }
+        } else if(arg == "--record-osc" && hasValue) {
+            settings.recordOscPath = argv[++i];
+        } else if(arg == "--sync" && hasValue) {
+            settings.syncRole = argv[++i];
+        } else if(arg == "--sync-port" && hasValue) {
+            settings.syncPort = ofToInt(argv[++i]);
+        } else if(arg == "--sync-to" && hasValue) {
+            settings.syncTargets = argv[++i];
+        } else {
+            ofLogWarning() << "Unknown argument: " << arg;
+        }
+    }
+    if(settings.fps <= 0) settings.fps = 30;
+    return render;
+}
+
+bool OfflineRenderer::setup(const Settings& newSettings) {
+    settings = newSettings;
+    frame = 0;
+
+    ofDirectory dir(settings.outputDir);
+    if(!dir.exists()) {
+        dir.create(true);
+    }
+    if(settings.format == "raw") {
+        string path = ofFilePath::join(settings.outputDir, "frames.rgba");
+        if(!rawFile.open(path, ofFile::WriteOnly, true)) {
+            ofLogError() << "Could not open " << path;
+            return false;
+        }
+    } else if(settings.format != "png") {
+        ofLogError() << "Unknown frame format " << settings.format << ", use png or raw";
+        return false;
+    }
+
+    if(!settings.oscPath.empty()) {
+        ofBuffer buffer = ofBufferFromFile(settings.oscPath);
+        for(const auto& line : buffer.getLines()) {
+            vector<string> parts = ofSplitString(line, " ", true, true);
+            if(parts.size() == 3) {
+                oscEvents.push_back({ofToFloat(parts[0]), parts[1], ofToFloat(parts[2])});
+            }
+        }
+        stable_sort(oscEvents.begin(), oscEvents.end(), [](const OscEvent& a, const OscEvent& b) {
+            return a.time < b.time;
+        });
+        ofLog() << "Replaying " << oscEvents.size() << " OSC messages from " << settings.oscPath;
+    }
+
+    fbo.allocate(settings.width, settings.height, GL_RGBA);
+    active = true;
+    frameStartMicros = ofGetElapsedTimeMicros();
+    ofLog() << "Rendering " << settings.frames << " frames at " << settings.fps << " fps to " << settings.outputDir;
+    return true;
+}
+
+void OfflineRenderer::replayOsc(const function<void(const string&, float)>& apply) {
+    float time = getTime();
+    while(nextOscEvent < oscEvents.size() && oscEvents[nextOscEvent].time <= time) {
+        apply(oscEvents[nextOscEvent].address, oscEvents[nextOscEvent].value);
+        nextOscEvent++;
+    }
+}
+
+void OfflineRenderer::begin() {
+    fbo.begin();
+}
+
+void OfflineRenderer::end() {
+    fbo.end();
+    fbo.readToPixels(pixels);
+    uint64_t rendered = ofGetElapsedTimeMicros();
+    renderMicros += rendered - frameStartMicros;
+
+    if(settings.format == "raw") {
+        rawFile.write(reinterpret_cast<const char*>(pixels.getData()), pixels.size());
+    } else {
+        ofSaveImage(pixels, ofFilePath::join(settings.outputDir, "frame_" + ofToString(frame, 6, '0') + ".png"));
+    }
+    writeMicros += ofGetElapsedTimeMicros() - rendered;
+
+    // Shown in the hidden window too, so a visible run can be watched
+    fbo.draw(0, 0);
+
+    frame++;
+    if(isDone() && rawFile.is_open()) {
+        rawFile.close();
+    }
+    frameStartMicros = ofGetElapsedTimeMicros();
+}
+
+void OfflineRenderer::printStats() const {
+    if(frame == 0) return;
+    double total = (renderMicros + writeMicros) / 1e6;
+    double render = renderMicros / 1e6;
+    ofLog() << "Rendered " << frame << " frames (" << settings.width << "x" << settings.height << ") in "
+            << ofToString(total, 2) << " s";
+    ofLog() << "Pipeline " << ofToString(frame / render, 1) << " fps, with writing "
+            << ofToString(frame / total, 1) << " fps";
+    if(settings.format == "raw") {
+        ofLog() << "Raw frames are RGBA8, e.g. ffmpeg -f rawvideo -pix_fmt rgba -s "
+                << settings.width << "x" << settings.height << " -r " << settings.fps << " -i frames.rgba";
+    }
+}
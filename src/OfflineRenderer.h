@@ -0,0 +1,85 @@
+#pragma once
+#include "ofMain.h"
+
+// Renders a layout frame by frame on a fixed clock instead of wall time and
+// writes each frame out, for golden images and full-pipeline throughput.
+//
+//   HainanProjectionMapping --render layouts/show.json [--frames 300]
+//       [--fps 30] [--out render] [--format png|raw] [--size 1400x1050]
+//       [--osc recording.txt]
+//
+// Frames go to <out>/frame_000000.png, or for raw to <out>/frames.rgba as
+// one stream of RGBA8 frames. The window stays hidden but a GL context is
+// still needed; on a machine without a display run it under xvfb-run.
+//
+//   HainanProjectionMapping --verify-remap layouts/show.json [--tolerance 2]
+//
+// loads the layout the same hidden way, lets its sources deliver a few
+// frames, then compares the shader color remap of every color-input tile
+// against the CPU kernel and exits: 0 when all are within tolerance, 1 when
+// one is over, 2 when nothing could be compared (no shader or no pixels).
+// For CI without a GPU: LIBGL_ALWAYS_SOFTWARE=1 xvfb-run ...
+//
+// OSC recordings are text lines of "<seconds> <address> <value>", written
+// by the live app with --record-osc <file> and replayed on the render clock.
+class OfflineRenderer {
+public:
+    struct Settings {
+        string layoutPath;
+        int frames = 300;
+        float fps = 30;
+        string outputDir = "render";
+        string format = "png";
+        string oscPath;
+        int width = 1400;
+        int height = 1050;
+        string recordOscPath;    // live mode only
+        string syncRole;         // live mode only, see PlaybackSync
+        int syncPort = 9100;
+        string syncTargets;
+        bool verifyRemap = false;    // --verify-remap, checks instead of rendering
+        int remapTolerance = 2;      // largest channel difference accepted
+    };
+
+    // Returns true when --render or --verify-remap was given
+    static bool parseArguments(int argc, char* argv[], Settings& settings);
+
+    bool setup(const Settings& settings);
+    bool isActive() const { return active; }
+    bool isDone() const { return frame >= settings.frames; }
+
+    // Render clock, in seconds
+    float getTime() const { return frame / settings.fps; }
+    float getFrameDuration() const { return 1.0f / settings.fps; }
+
+    // Replays OSC messages up to the current time through the callback
+    void replayOsc(const function<void(const string&, float)>& apply);
+
+    // Wrap one frame's drawing; end() writes it and advances the clock
+    void begin();
+    void end();
+
+    // Frames per second over the whole run, with and without writing frames
+    void printStats() const;
+
+private:
+    struct OscEvent {
+        float time;
+        string address;
+        float value;
+    };
+
+    Settings settings;
+    bool active = false;
+    int frame = 0;
+    ofFbo fbo;
+    ofPixels pixels;
+    ofFile rawFile;
+
+    vector<OscEvent> oscEvents;
+    size_t nextOscEvent = 0;
+
+    uint64_t frameStartMicros = 0;
+    uint64_t renderMicros = 0;   // update, draw and readback
+    uint64_t writeMicros = 0;
+};
@@ -0,0 +1,75 @@
+#include "OutputWindow.h"
+
+ofJson OutputWindow::Settings::toJson() const {
+    return {
+        {"x", bounds.x},
+        {"y", bounds.y},
+        {"width", bounds.width},
+        {"height", bounds.height},
+        {"fullscreen", fullscreen}
+    };
+}
+
+OutputWindow::Settings OutputWindow::Settings::fromJson(const ofJson& data) {
+    Settings settings;
+    if(data.contains("x") && data.contains("y")) {
+        settings.bounds.setPosition(data["x"].get<float>(), data["y"].get<float>());
+    }
+    if(data.contains("width") && data.contains("height")) {
+        settings.bounds.width = data["width"].get<float>();
+        settings.bounds.height = data["height"].get<float>();
+    }
+    if(data.contains("fullscreen")) {
+        settings.fullscreen = data["fullscreen"];
+    }
+    return settings;
+}
+
+bool OutputWindow::open(const shared_ptr<ofAppBaseWindow>& mainWindow, const Settings& settings,
+                        std::function<void()> onDraw) {
+    close();
+
+    ofGLFWWindowSettings windowSettings;
+    windowSettings.setSize(settings.bounds.width, settings.bounds.height);
+    windowSettings.setPosition(glm::vec2(settings.bounds.x, settings.bounds.y));
+    windowSettings.windowMode = settings.fullscreen ? OF_FULLSCREEN : OF_WINDOW;
+    windowSettings.shareContextWith = mainWindow;
+    window = ofCreateWindow(windowSettings);
+    if(!window) {
+        ofLogError() << "Could not open output window";
+        return false;
+    }
+    window->setWindowTitle("Output");
+    drawListener = window->events().draw.newListener([onDraw](ofEventArgs&) {
+        onDraw();
+    });
+    staticLayer.invalidate();
+    return true;
+}
+
+void OutputWindow::close() {
+    if(!window) return;
+    drawListener.unsubscribe();
+    window->setWindowShouldClose();
+    window.reset();
+}
+
+void OutputWindow::apply(const Settings& settings) {
+    if(!window) return;
+    window->setFullscreen(settings.fullscreen);
+    if(!settings.fullscreen) {
+        window->setWindowPosition(settings.bounds.x, settings.bounds.y);
+        window->setWindowShape(settings.bounds.width, settings.bounds.height);
+    }
+    staticLayer.invalidate();
+}
+
+OutputWindow::Settings OutputWindow::getSettings() const {
+    Settings settings;
+    if(!window) return settings;
+    glm::vec2 position = window->getWindowPosition();
+    glm::vec2 size = window->getWindowSize();
+    settings.bounds.set(position.x, position.y, size.x, size.y);
+    settings.fullscreen = window->getWindowMode() == OF_FULLSCREEN;
+    return settings;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include "ofMain.h"
+#include "StaticLayerCache.h"
+
+// A secondary projector window. It shares the main window's GL context, so
+// videos, cameras and images are decoded and uploaded once and drawn by
+// every output. Output 0 is the main window itself; each extra window shows
+// only the tiles assigned to it, in its own window coordinates.
+//
+// FBOs are not shared between contexts, so every output keeps its own
+// static layer of image tiles.
+class OutputWindow {
+public:
+    struct Settings {
+        ofRectangle bounds = ofRectangle(0, 0, 1024, 768);    // screen position and size
+        bool fullscreen = false;
+
+        ofJson toJson() const;
+        static Settings fromJson(const ofJson& data);
+    };
+
+    OutputWindow() = default;
+    ~OutputWindow() { close(); }
+    OutputWindow(const OutputWindow&) = delete;
+    OutputWindow& operator=(const OutputWindow&) = delete;
+
+    // Opens the window sharing mainWindow's context. onDraw runs with the
+    // output's context current, once per frame.
+    bool open(const shared_ptr<ofAppBaseWindow>& mainWindow, const Settings& settings,
+              std::function<void()> onDraw);
+    void close();
+    bool isOpen() const { return window != nullptr; }
+
+    // Moves and resizes an open window
+    void apply(const Settings& settings);
+    // Current placement, including moves made by hand
+    Settings getSettings() const;
+
+    StaticLayerCache staticLayer;
+
+private:
+    shared_ptr<ofAppBaseWindow> window;
+    ofEventListener drawListener;
+};
@@ -0,0 +1,233 @@
+#include "PixelBufferRing.h"
+#include "RegionSet.h"
+
+PixelBufferRing::PixelBufferRing() {
+}
+
+PixelBufferRing::~PixelBufferRing() {
+    clear();
+}
+
+bool PixelBufferRing::isSupported() {
+#ifdef TARGET_OPENGLES
+    return false;
+#else
+    auto renderer = ofGetGLRenderer();
+    if(!renderer) return false;
+    int major = renderer->getGLVersionMajor();
+    int minor = renderer->getGLVersionMinor();
+    return major > 2 || (major == 2 && minor >= 1) || ofGLCheckExtension("GL_ARB_pixel_buffer_object");
+#endif
+}
+
+bool PixelBufferRing::allocate(int width, int height, ofPixelFormat format, int numBuffers) {
+    clear();
+    if(!isSupported()) return false;
+
+    this->width = width;
+    this->height = height;
+    pixelFormat = format;
+    bytesPerFrame = ofPixels::bytesFromPixelFormat(width, height, format);
+    bytesPerPixel = bytesPerFrame / (size_t(width) * height);
+    if(bytesPerPixel * width * height != bytesPerFrame) bytesPerPixel = 0;
+    firstFrame = true;
+    persistent = ofGLCheckExtension("GL_ARB_buffer_storage");
+
+    numSlots = numBuffers;
+    slots.reset(new Slot[numSlots]);
+    for(int i = 0; i < numSlots; i++) {
+        Slot& slot = slots[i];
+        glGenBuffers(1, &slot.buffer);
+
+        if(persistent) {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+            glBufferStorage(GL_PIXEL_UNPACK_BUFFER, bytesPerFrame, nullptr, flags);
+            slot.data = static_cast<unsigned char*>(
+                glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytesPerFrame, flags));
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        } else {
+            mapSlot(slot);
+        }
+
+        if(!slot.data) {
+            ofLogError() << "Failed to map pixel buffer, falling back to direct uploads";
+            clear();
+            return false;
+        }
+    }
+
+    texture.allocate(width, height, ofGetGLInternalFormatFromPixelFormat(format));
+    allocated = true;
+    return true;
+}
+
+void PixelBufferRing::clear() {
+    allocated = false;
+
+    for(int i = 0; i < numSlots; i++) {
+        Slot& slot = slots[i];
+        if(slot.fence) {
+            glDeleteSync(slot.fence);
+        }
+        if(slot.buffer) {
+            if(slot.data) {
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+                glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            }
+            glDeleteBuffers(1, &slot.buffer);
+        }
+    }
+
+    slots.reset();
+    numSlots = 0;
+    texture.clear();
+    frameIsNew = false;
+}
+
+bool PixelBufferRing::matches(const ofPixels& pixels) const {
+    return allocated &&
+           pixels.getWidth() == width &&
+           pixels.getHeight() == height &&
+           pixels.getPixelFormat() == pixelFormat &&
+           pixels.getTotalBytes() == bytesPerFrame;
+}
+
+unsigned char* PixelBufferRing::beginWrite(int& slotIndex) {
+    if(!allocated) return nullptr;
+
+    for(int i = 0; i < numSlots; i++) {
+        int expected = SLOT_FREE;
+        if(slots[i].state.compare_exchange_strong(expected, SLOT_WRITING)) {
+            slotIndex = i;
+            return slots[i].data;
+        }
+    }
+    return nullptr;
+}
+
+void PixelBufferRing::endWrite(int slotIndex, uint64_t frameTimestamp) {
+    Slot& slot = slots[slotIndex];
+    slot.timestamp = frameTimestamp;
+    slot.sequence = ++nextSequence;
+    slot.state = SLOT_READY;
+}
+
+bool PixelBufferRing::write(const ofPixels& pixels, uint64_t frameTimestamp) {
+    if(!matches(pixels)) return false;
+
+    int slotIndex;
+    unsigned char* data = beginWrite(slotIndex);
+    if(!data) return false;
+
+    Slot& slot = slots[slotIndex];
+    {
+        std::lock_guard<std::mutex> lock(regionsMutex);
+        slot.regions = firstFrame.exchange(false) || !bytesPerPixel ? nullptr : regions;
+    }
+    if(slot.regions) {
+        RegionSet::copy(*slot.regions, width, pixels.getData(), data, bytesPerPixel);
+    } else {
+        memcpy(data, pixels.getData(), bytesPerFrame);
+    }
+    endWrite(slotIndex, frameTimestamp);
+    return true;
+}
+
+void PixelBufferRing::setRegions(const vector<ofRectangle>& newRegions) {
+    auto shared = make_shared<const vector<ofRectangle>>(newRegions);
+    std::lock_guard<std::mutex> lock(regionsMutex);
+    regions = shared;
+}
+
+void PixelBufferRing::setFullFrame() {
+    std::lock_guard<std::mutex> lock(regionsMutex);
+    regions.reset();
+}
+
+bool PixelBufferRing::update() {
+    frameIsNew = false;
+    if(!allocated) return false;
+
+    Slot* newest = nullptr;
+    for(int i = 0; i < numSlots; i++) {
+        Slot& slot = slots[i];
+        int state = slot.state.load();
+
+        if(state == SLOT_UPLOADING) {
+            // Recycle slots once the GPU has finished reading them
+            if(persistent) {
+                GLenum result = glClientWaitSync(slot.fence, 0, 0);
+                if(result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED) {
+                    glDeleteSync(slot.fence);
+                    slot.fence = nullptr;
+                    slot.state = SLOT_FREE;
+                }
+            } else if(mapSlot(slot)) {
+                slot.state = SLOT_FREE;
+            }
+        } else if(state == SLOT_READY) {
+            // Only the newest frame is worth uploading, drop any it supersedes
+            if(!newest) {
+                newest = &slot;
+            } else if(slot.sequence > newest->sequence) {
+                newest->state = SLOT_FREE;
+                newest = &slot;
+            } else {
+                slot.state = SLOT_FREE;
+            }
+        }
+    }
+
+    if(!newest) return false;
+
+    upload(*newest);
+    timestamp = newest->timestamp;
+    frameIsNew = true;
+    return true;
+}
+
+bool PixelBufferRing::mapSlot(Slot& slot) {
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+    // Orphan the old storage so mapping never waits on a pending upload
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, bytesPerFrame, nullptr, GL_STREAM_DRAW);
+    slot.data = static_cast<unsigned char*>(glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY));
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    return slot.data != nullptr;
+}
+
+void PixelBufferRing::upload(Slot& slot) {
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+    if(!persistent) {
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        slot.data = nullptr;
+    }
+
+    // Sourced from the bound buffer, so this returns without copying
+    const ofTextureData& texData = texture.getTextureData();
+    glBindTexture(texData.textureTarget, texData.textureID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    GLenum glFormat = ofGetGLFormatFromPixelFormat(pixelFormat);
+    if(slot.regions) {
+        // Offsets into the bound buffer, rows spaced by the full frame width
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, width);
+        for(const auto& rect : *slot.regions) {
+            size_t offset = (size_t(rect.y) * width + size_t(rect.x)) * bytesPerPixel;
+            glTexSubImage2D(texData.textureTarget, 0, rect.x, rect.y, rect.width, rect.height,
+                            glFormat, GL_UNSIGNED_BYTE, reinterpret_cast<const void*>(offset));
+        }
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    } else {
+        glTexSubImage2D(texData.textureTarget, 0, 0, 0, width, height,
+                        glFormat, GL_UNSIGNED_BYTE, nullptr);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(texData.textureTarget, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if(persistent) {
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    slot.state = SLOT_UPLOADING;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include "ofMain.h"
+#include <atomic>
+
+// Small ring of mapped pixel buffer objects feeding one texture.
+//
+// A producer on any thread borrows a mapped slot, writes a frame straight
+// into it and commits it. The render thread then starts an asynchronous
+// texture update from the newest committed slot, so neither side waits on
+// the other or on the GPU.
+//
+// Buffers are persistently mapped when GL_ARB_buffer_storage is available,
+// otherwise they are orphaned and re-mapped after each upload. When pixel
+// buffer objects are not available at all, isSupported() is false and
+// callers keep uploading from ofPixels.
+//
+// Copies and uploads can be limited to a set of rectangles of the frame.
+// The texture outside them keeps whatever was last uploaded there; the first
+// frame after allocation is always uploaded whole.
+class PixelBufferRing {
+public:
+    PixelBufferRing();
+    ~PixelBufferRing();
+
+    static bool isSupported();
+
+    // Render thread
+    bool allocate(int width, int height, ofPixelFormat format, int numBuffers = 3);
+    void clear();
+    bool update();
+
+    bool isAllocated() const { return allocated; }
+    bool isFrameNew() const { return frameIsNew; }
+    bool matches(const ofPixels& pixels) const;
+    const ofTexture& getTexture() const { return texture; }
+    // Driver memory held by the buffers
+    size_t getBufferBytes() const { return size_t(numSlots) * bytesPerFrame; }
+    uint64_t getTimestamp() const { return timestamp; }
+
+    // Producer side, safe from any thread. beginWrite() returns nullptr when
+    // every slot is busy, otherwise the mapped memory of the borrowed slot.
+    unsigned char* beginWrite(int& slotIndex);
+    void endWrite(int slotIndex, uint64_t frameTimestamp);
+    bool write(const ofPixels& pixels, uint64_t frameTimestamp);
+
+    // Limits write() and the upload to these rectangles, safe from any thread.
+    // Frames in planar formats are always copied whole.
+    void setRegions(const vector<ofRectangle>& regions);
+    void setFullFrame();
+
+private:
+    enum SlotState {
+        SLOT_FREE,          // mapped and waiting for the producer
+        SLOT_WRITING,       // producer is filling it
+        SLOT_READY,         // holds a complete frame
+        SLOT_UPLOADING      // texture update still reading from it
+    };
+
+    struct Slot {
+        GLuint buffer = 0;
+        unsigned char* data = nullptr;
+        GLsync fence = nullptr;
+        uint64_t sequence = 0;
+        uint64_t timestamp = 0;
+        shared_ptr<const vector<ofRectangle>> regions;    // null for the whole frame
+        std::atomic<int> state{SLOT_FREE};
+    };
+
+    bool mapSlot(Slot& slot);
+    void upload(Slot& slot);
+
+    unique_ptr<Slot[]> slots;
+    int numSlots = 0;
+    std::atomic<uint64_t> nextSequence{0};
+    std::atomic<bool> allocated{false};
+
+    bool persistent = false;
+    int width = 0;
+    int height = 0;
+    ofPixelFormat pixelFormat = OF_PIXELS_RGB;
+    size_t bytesPerFrame = 0;
+    size_t bytesPerPixel = 0;          // 0 for planar formats
+
+    std::mutex regionsMutex;
+    shared_ptr<const vector<ofRectangle>> regions;
+    std::atomic<bool> firstFrame{true};
+
+    ofTexture texture;
+    bool frameIsNew = false;
+    uint64_t timestamp = 0;
+};
@@ -0,0 +1,147 @@
+#include "PlaybackSync.h"
+
+static const string CLOCK_ADDRESS = "/sync/video";
+
+// Difference between two playheads of a loop, the short way around
+static float wrapAround(float difference, float duration) {
+    difference = fmod(difference, duration);
+    if(difference > duration / 2) difference -= duration;
+    if(difference < -duration / 2) difference += duration;
+    return difference;
+}
+
+PlaybackSync::Role PlaybackSync::parseRole(const string& name) {
+    if(name == "master") return MASTER;
+    if(name == "follower") return FOLLOWER;
+    if(!name.empty()) {
+        ofLogWarning() << "Unknown sync role " << name << ", use master or follower";
+    }
+    return OFF;
+}
+
+bool PlaybackSync::setup(Role newRole, int port, const string& targets) {
+    role = newRole;
+    if(role == MASTER) {
+        string list = targets.empty() ? "255.255.255.255:" + ofToString(port) : targets;
+        for(const auto& target : ofSplitString(list, ",", true, true)) {
+            vector<string> parts = ofSplitString(target, ":");
+            int targetPort = parts.size() > 1 ? ofToInt(parts[1]) : port;
+            auto sender = make_unique<ofxOscSender>();
+            if(!sender->setup(parts[0], targetPort)) {
+                ofLogError() << "Playback sync could not send to " << target;
+                continue;
+            }
+            senders.push_back(move(sender));
+        }
+        ofLog() << "Playback sync master, sending to " << list;
+        if(senders.empty()) role = OFF;
+    } else if(role == FOLLOWER) {
+        if(!receiver.setup(port)) {
+            ofLogError() << "Playback sync could not listen on port " << port;
+            role = OFF;
+        } else {
+            ofLog() << "Playback sync follower on port " << port;
+        }
+    }
+    return role == newRole;
+}
+
+void PlaybackSync::send(const vector<VideoSource>& videos) {
+    sequence++;
+    for(const auto& video : videos) {
+        if(!video.isLoaded()) continue;
+        ofxOscMessage message;
+        message.setAddress(CLOCK_ADDRESS);
+        message.addStringArg(getName(video));
+        message.addFloatArg(video.getTime());
+        message.addIntArg(video.getCurrentFrame());
+        message.addIntArg(sequence);
+        for(auto& sender : senders) {
+            sender->sendMessage(message, false);
+        }
+    }
+    numSent++;
+}
+
+void PlaybackSync::receive() {
+    float now = ofGetElapsedTimef();
+    while(receiver.hasWaitingMessages()) {
+        ofxOscMessage message;
+        receiver.getNextMessage(message);
+        if(message.getAddress() != CLOCK_ADDRESS || message.getNumArgs() < 4) continue;
+
+        // Packets can arrive out of order; a restarted master counts from zero again
+        Source& source = sources[message.getArgAsString(0)];
+        int messageSequence = message.getArgAsInt32(3);
+        if(source.hasClock && messageSequence <= source.sequence && source.sequence - messageSequence < 1000) {
+            numLate++;
+            continue;
+        }
+        source.hasClock = true;
+        source.sequence = messageSequence;
+        source.masterTime = message.getArgAsFloat(1);
+        source.masterFrame = message.getArgAsInt32(2);
+        source.receivedAt = now;
+        numReceived++;
+    }
+}
+
+float PlaybackSync::correct(VideoSource& video) {
+    auto it = sources.find(getName(video));
+    float duration = video.getDuration();
+    if(it == sources.end() || duration <= 0) return 1;
+
+    Source& source = it->second;
+    source.localFrame = video.getCurrentFrame();
+    float now = ofGetElapsedTimef();
+    if(now - source.receivedAt > TIMEOUT) {
+        // The master went quiet, play on freely
+        source.rate = 1;
+        return 1;
+    }
+    if(now - source.seekedAt < SEEK_SETTLE) return 1;
+
+    // The master kept playing at normal speed since it sent its clock
+    float masterTime = source.masterTime + (now - source.receivedAt);
+    float drift = wrapAround(video.getTime() - masterTime, duration);
+    if(fabs(drift) > SEEK_THRESHOLD) {
+        // Too far off to steer back in reasonable time
+        video.seekTo(masterTime);
+        source.seeks++;
+        source.seekedAt = now;
+        source.drift = 0;
+        source.rate = 1;
+        return 1;
+    }
+
+    source.drift = ofLerp(source.drift, drift, DRIFT_SMOOTHING);
+    source.rate = 1 - ofClamp(source.drift * CORRECTION_GAIN, -MAX_RATE_ADJUST, MAX_RATE_ADJUST);
+    return source.rate;
+}
+
+void PlaybackSync::draw(float x, float bottom) const {
+    stringstream text;
+    size_t lines = 1;
+    if(role == MASTER) {
+        text << "sync master: " << numSent << " clocks sent to " << senders.size() << " targets\n";
+    } else {
+        text << "sync follower: " << numReceived << " clocks, " << numLate << " late\n";
+        float now = ofGetElapsedTimef();
+        for(const auto& entry : sources) {
+            const Source& source = entry.second;
+            text << ofToString(entry.first.substr(0, 24), 24, ' ')
+                 << " drift " << ofToString(source.drift * 1000, 1, 7, ' ') << " ms"
+                 << "  rate " << ofToString(source.rate, 3)
+                 << "  frame " << source.localFrame << "/" << source.masterFrame
+                 << "  seeks " << source.seeks
+                 << (now - source.receivedAt > TIMEOUT ? "  lost" : "") << "\n";
+            lines++;
+        }
+    }
+    // Bitmap font lines are 14px apart
+    ofDrawBitmapStringHighlight(text.str(), x, bottom - lines * 14);
+}
+
+string PlaybackSync::getName(const VideoSource& video) {
+    return ofFilePath::getFileName(video.getMoviePath());
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include "ofMain.h"
+#include "ofxOsc.h"
+#include "VideoSource.h"
+
+// Keeps looping videos frame-locked across render nodes that share one
+// canvas. The master sends every video's playhead and frame index over OSC
+// each frame. Followers steer their playback rate toward it rather than
+// seeking, so corrections never show as jumps. Videos are matched by file
+// name, so nodes may load different layouts of the same media.
+//
+//   HainanProjectionMapping --sync master [--sync-to host:port,...]
+//   HainanProjectionMapping --sync follower [--sync-port 9100]
+//
+// The master sends to the broadcast address by default. To try it on one
+// machine, give each follower its own port and list them all in --sync-to:
+//   --sync master --sync-to 127.0.0.1:9101,127.0.0.1:9102
+//   --sync follower --sync-port 9101
+//   --sync follower --sync-port 9102
+class PlaybackSync {
+public:
+    enum Role { OFF, MASTER, FOLLOWER };
+
+    static constexpr float MAX_RATE_ADJUST = 0.05f;  // followers play at most 5% off speed
+    static constexpr float CORRECTION_GAIN = 0.5f;   // rate change per second of drift
+    static constexpr float DRIFT_SMOOTHING = 0.1f;   // playheads move in whole frames
+    static constexpr float SEEK_THRESHOLD = 1.0f;    // drift in seconds that is jumped, e.g. on joining
+    static constexpr float SEEK_SETTLE = 0.5f;       // seconds a seek is given to land
+    static constexpr float TIMEOUT = 2.0f;           // seconds without a clock before playing freely
+
+    static Role parseRole(const string& name);
+
+    bool setup(Role role, int port, const string& targets);
+    Role getRole() const { return role; }
+    bool isActive() const { return role != OFF; }
+
+    // Master: sends the playheads of all videos
+    void send(const vector<VideoSource>& videos);
+
+    // Follower: takes in the clocks that arrived since the last frame
+    void receive();
+    // Follower: playback rate that brings a looping video toward the
+    // master's playhead. Seeks instead when it is too far off.
+    float correct(VideoSource& video);
+
+    // Drift and correction per video, drawn upwards from the bottom-left corner
+    void draw(float x, float bottom) const;
+
+private:
+    struct Source {
+        // Last clock from the master
+        bool hasClock = false;
+        int sequence = 0;
+        float masterTime = 0;
+        int masterFrame = 0;
+        float receivedAt = 0;
+
+        // Correction on this node
+        float drift = 0;       // seconds ahead of the master, smoothed
+        float rate = 1;
+        int localFrame = 0;
+        int seeks = 0;
+        float seekedAt = -SEEK_SETTLE;
+    };
+
+    static string getName(const VideoSource& video);
+
+    Role role = OFF;
+    vector<unique_ptr<ofxOscSender>> senders;
+    ofxOscReceiver receiver;
+    map<string, Source> sources;
+    int sequence = 0;
+    uint64_t numSent = 0;
+    uint64_t numReceived = 0;
+    uint64_t numLate = 0;
+};
@@ -0,0 +1,54 @@
+#include "Profiler.h"
+
+vector<Profiler::Stage> Profiler::stages;
+size_t Profiler::historyPosition = 0;
+size_t Profiler::historySize = 0;
+bool Profiler::visible = false;
+
+int Profiler::getStage(const char* name) {
+    for(size_t i = 0; i < stages.size(); i++) {
+        if(stages[i].name == name) return i;
+    }
+    stages.emplace_back();
+    stages.back().name = name;
+    stages.back().history.assign(HISTORY_FRAMES, 0);
+    return stages.size() - 1;
+}
+
+void Profiler::frameDone() {
+    for(auto& stage : stages) {
+        stage.history[historyPosition] = stage.frameMicros;
+        stage.lastCalls = stage.frameCalls;
+        stage.frameMicros = 0;
+        stage.frameCalls = 0;
+    }
+    historyPosition = (historyPosition + 1) % HISTORY_FRAMES;
+    historySize = min(historySize + 1, HISTORY_FRAMES);
+}
+
+void Profiler::draw(float x, float bottom) {
+    if(stages.empty()) {
+        ofDrawBitmapStringHighlight("Profiler compiled out, build with TILE_PROFILER", x, bottom);
+        return;
+    }
+
+    // Percentiles over the frames recorded so far, oldest frames drop out
+    stringstream text;
+    text << ofToString("stage", 20, ' ') << "   p50    p95    p99    max  calls (ms, " << historySize << " frames)\n";
+    vector<float> sorted;
+    for(const auto& stage : stages) {
+        sorted.assign(stage.history.begin(), stage.history.begin() + historySize);
+        sort(sorted.begin(), sorted.end());
+        auto percentile = [&](float p) {
+            return sorted.empty() ? 0.0f : sorted[min<size_t>(p * sorted.size(), sorted.size() - 1)] / 1000.0f;
+        };
+        text << ofToString(stage.name, 20, ' ')
+             << ofToString(percentile(0.50f), 2, 6, ' ') << " "
+             << ofToString(percentile(0.95f), 2, 6, ' ') << " "
+             << ofToString(percentile(0.99f), 2, 6, ' ') << " "
+             << ofToString(sorted.empty() ? 0.0f : sorted.back() / 1000.0f, 2, 6, ' ') << " "
+             << ofToString(stage.lastCalls, 6, ' ') << "\n";
+    }
+    // Bitmap font lines are 14px apart
+    ofDrawBitmapStringHighlight(text.str(), x, bottom - stages.size() * 14);
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include "ofMain.h"
+#include "TraceRecorder.h"
+
+// Frame-time profiler. PROFILE_SCOPE("name") times the rest of the enclosing
+// block; times from every scope with the same name are summed per frame and
+// the last HISTORY_FRAMES frames give the percentiles shown in the HUD.
+//
+// While a trace is recording every scope is also written to it.
+//
+// Scopes only exist when TILE_PROFILER is defined (see config.make).
+// Without it the macro expands to nothing and the profiler is never fed.
+// Stages are per frame, so PROFILE_SCOPE is for the main thread only;
+// other threads use TRACE_SCOPE.
+class Profiler {
+public:
+    static const size_t HISTORY_FRAMES = 240;
+
+    // Stage ids are looked up once per scope site
+    static int getStage(const char* name);
+    static void add(int stage, double micros) { stages[stage].frameMicros += micros; stages[stage].frameCalls++; }
+
+    // Closes the frame: pushes each stage's total into its history
+    static void frameDone();
+
+    static bool isVisible() { return visible; }
+    static void setVisible(bool show) { visible = show; }
+    static void toggle() { visible = !visible; }
+
+    // Stage table with p50/p95/p99 and max over the history, in ms,
+    // drawn upwards from the bottom-left corner
+    static void draw(float x, float bottom);
+
+private:
+    struct Stage {
+        string name;
+        double frameMicros = 0;
+        int frameCalls = 0;
+        vector<float> history;   // ring of per-frame totals, in microseconds
+        int lastCalls = 0;
+    };
+
+    static vector<Stage> stages;
+    static size_t historyPosition;
+    static size_t historySize;
+    static bool visible;
+};
+
+class ProfileScope {
+public:
+    ProfileScope(int stage, const char* name) : stage(stage), name(name), start(std::chrono::steady_clock::now()) {}
+    ~ProfileScope() {
+        auto end = std::chrono::steady_clock::now();
+        Profiler::add(stage, std::chrono::duration<double, std::micro>(end - start).count());
+        if(TraceRecorder::isRecording()) {
+            TraceRecorder::add(name, std::chrono::duration_cast<std::chrono::microseconds>(start.time_since_epoch()).count());
+        }
+    }
+
+private:
+    int stage;
+    const char* name;
+    std::chrono::steady_clock::time_point start;
+};
+
+#ifdef TILE_PROFILER
+#define PROFILE_SCOPE(name) \
+    static const int TRACE_CONCAT(profileStage, __LINE__) = Profiler::getStage(name); \
+    ProfileScope TRACE_CONCAT(profileScope, __LINE__)(TRACE_CONCAT(profileStage, __LINE__), name)
+#else
+#define PROFILE_SCOPE(name)
+#endif
@@ -0,0 +1,98 @@
+#include "RegionSet.h"
+
+bool RegionSet::update(int frameWidth, int frameHeight, const vector<ofRectangle>& regions) {
+    if(frameWidth == width && frameHeight == height && regions == input) return false;
+    width = frameWidth;
+    height = frameHeight;
+    input = regions;
+    rects.clear();
+    coveredPixels = 0;
+    if(width <= 0 || height <= 0) return true;
+
+    // Mark the cells each region touches, one pixel of filter margin around it
+    int columns = (width + CELL_SIZE - 1) / CELL_SIZE;
+    int rows = (height + CELL_SIZE - 1) / CELL_SIZE;
+    vector<unsigned char> cells(columns * rows, 0);
+    ofRectangle bounds;
+    bool any = false;
+    for(const auto& region : regions) {
+        int x0 = max(0, int(floor(region.getLeft())) - 1) / CELL_SIZE;
+        int y0 = max(0, int(floor(region.getTop())) - 1) / CELL_SIZE;
+        int x1 = min(width, int(ceil(region.getRight())) + 1);
+        int y1 = min(height, int(ceil(region.getBottom())) + 1);
+        x1 = (x1 + CELL_SIZE - 1) / CELL_SIZE;
+        y1 = (y1 + CELL_SIZE - 1) / CELL_SIZE;
+        if(x0 >= x1 || y0 >= y1) continue;
+
+        for(int y = y0; y < y1; y++) {
+            fill(cells.begin() + y * columns + x0, cells.begin() + y * columns + x1, 1);
+        }
+        ofRectangle cellRect(x0, y0, x1 - x0, y1 - y0);
+        if(any) {
+            bounds.growToInclude(cellRect);
+        } else {
+            bounds = cellRect;
+            any = true;
+        }
+    }
+    if(!any) return true;
+
+    // Runs of marked cells per row, extended downwards while the next row
+    // has exactly the same run
+    vector<ofRectangle> open;
+    vector<ofRectangle> next;
+    for(int y = 0; y <= rows; y++) {
+        next.clear();
+        for(int x = 0; y < rows && x < columns; ) {
+            if(!cells[y * columns + x]) {
+                x++;
+                continue;
+            }
+            int start = x;
+            while(x < columns && cells[y * columns + x]) x++;
+
+            ofRectangle run(start, y, x - start, 1);
+            auto match = find_if(open.begin(), open.end(), [&](const ofRectangle& r) {
+                return r.x == run.x && r.width == run.width;
+            });
+            if(match != open.end()) {
+                run.y = match->y;
+                run.height = match->height + 1;
+                open.erase(match);
+            }
+            next.push_back(run);
+        }
+        rects.insert(rects.end(), open.begin(), open.end());
+        open.swap(next);
+    }
+    if(rects.size() > MAX_RECTS) {
+        rects.assign(1, bounds);
+    }
+
+    // Back to pixels, clipped to the frame
+    for(auto& rect : rects) {
+        int x = rect.x * CELL_SIZE;
+        int y = rect.y * CELL_SIZE;
+        rect.set(x, y, min<int>(rect.width * CELL_SIZE, width - x), min<int>(rect.height * CELL_SIZE, height - y));
+        coveredPixels += size_t(rect.width) * rect.height;
+    }
+    return true;
+}
+
+float RegionSet::getSavedFraction() const {
+    if(width <= 0 || height <= 0) return 0;
+    return 1.0f - coveredPixels / float(size_t(width) * height);
+}
+
+void RegionSet::copy(const vector<ofRectangle>& rects, int frameWidth, const unsigned char* source,
+                     unsigned char* destination, size_t bytesPerPixel) {
+    size_t stride = size_t(frameWidth) * bytesPerPixel;
+    for(const auto& rect : rects) {
+        size_t offset = size_t(rect.y) * stride + size_t(rect.x) * bytesPerPixel;
+        size_t rowBytes = size_t(rect.width) * bytesPerPixel;
+        for(int y = 0; y < rect.height; y++) {
+            memcpy(destination + offset, source + offset, rowBytes);
+            offset += stride;
+        }
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "ofMain.h"
+
+// The parts of a source frame that tiles actually sample, as a few disjoint
+// rectangles, so frame copies and texture uploads can skip everything else.
+//
+// Tile regions are grown by a pixel for filtering, snapped out to a grid of
+// CELL_SIZE cells and merged into rectangles row by row. Past MAX_RECTS the
+// set collapses to the bounding box of all regions.
+class RegionSet {
+public:
+    static const int CELL_SIZE = 16;
+    static const int MAX_RECTS = 16;
+
+    // Rebuilds from the regions tiles read. Returns true if the set changed.
+    bool update(int frameWidth, int frameHeight, const vector<ofRectangle>& regions);
+
+    const vector<ofRectangle>& getRects() const { return rects; }
+    bool isFullFrame() const { return coveredPixels == size_t(width) * height; }
+    size_t getCoveredPixels() const { return coveredPixels; }
+    // Share of the frame no tile reads
+    float getSavedFraction() const;
+
+    // Copies rectangles between two frames of the same width
+    static void copy(const vector<ofRectangle>& rects, int frameWidth, const unsigned char* source,
+                     unsigned char* destination, size_t bytesPerPixel);
+
+private:
+    vector<ofRectangle> input;
+    vector<ofRectangle> rects;
+    int width = 0;
+    int height = 0;
+    size_t coveredPixels = 0;
+};
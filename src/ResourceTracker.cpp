@@ -0,0 +1,130 @@
+#include "ResourceTracker.h"
+
+uint64_t ResourceTracker::getBytes(const ofTexture& texture) {
+    if(!texture.isAllocated()) return 0;
+
+    const ofTextureData& data = texture.getTextureData();
+    int bytesPerPixel;
+    switch(data.glInternalFormat) {
+        case GL_R8:
+        case GL_LUMINANCE:
+        case GL_LUMINANCE8:
+        case GL_ALPHA:
+            bytesPerPixel = 1;
+            break;
+        case GL_RG8:
+        case GL_LUMINANCE_ALPHA:
+        case GL_R16F:
+            bytesPerPixel = 2;
+            break;
+        case GL_RGB:
+        case GL_RGB8:
+            bytesPerPixel = 3;
+            break;
+        case GL_RGBA16F:
+            bytesPerPixel = 8;
+            break;
+        case GL_RGBA32F:
+            bytesPerPixel = 16;
+            break;
+        default:
+            bytesPerPixel = 4;
+            break;
+    }
+    // tex_w and tex_h are the allocated size, padded for power-of-two textures
+    return uint64_t(data.tex_w) * uint64_t(data.tex_h) * bytesPerPixel;
+}
+
+string ResourceTracker::formatBytes(uint64_t bytes) {
+    if(bytes >= 1ull << 30) return ofToString(bytes / double(1ull << 30), 2) + " GB";
+    if(bytes >= 1ull << 20) return ofToString(bytes / double(1ull << 20), 1) + " MB";
+    if(bytes >= 1ull << 10) return ofToString(bytes / double(1ull << 10), 1) + " KB";
+    return ofToString(bytes) + " B";
+}
+
+void ResourceTracker::add(Kind kind, const string& name, const Usage& usage, int references) {
+    entries.push_back({kind, name, usage, references});
+}
+
+ResourceTracker::Usage ResourceTracker::getTotal() const {
+    Usage total;
+    for(const auto& entry : entries) {
+        total += entry.usage;
+    }
+    return total;
+}
+
+size_t ResourceTracker::getNumUnreferenced() const {
+    return count_if(entries.begin(), entries.end(), [](const Entry& entry) { return entry.references == 0; });
+}
+
+const char* ResourceTracker::getKindName(Kind kind) {
+    switch(kind) {
+        case VIDEO: return "video";
+        case IMAGE: return "image";
+        case CAMERA: return "camera";
+        case TILE: return "tile";
+        default: return "pool";
+    }
+}
+
+void ResourceTracker::draw(float x, float top) const {
+    auto addLine = [](stringstream& text, const string& name, const Usage& usage, const string& note) {
+        text << ofToString(name.substr(0, 28), 28, ' ') << " "
+             << ofToString(formatBytes(usage.cpu), 10, ' ') << " "
+             << ofToString(formatBytes(usage.gpu), 10, ' ') << " "
+             << ofToString(formatBytes(usage.mapped), 10, ' ') << "  " << note << "\n";
+    };
+
+    stringstream text;
+    text << ofToString("resource", 28, ' ') << "        cpu        gpu     mapped\n";
+    map<string, Usage> tileUsage;
+    map<string, int> tileCounts;
+    for(const auto& entry : entries) {
+        if(entry.kind == TILE) {
+            // Tiles are named "<kind> <index>", summed per kind
+            string kind = entry.name.substr(0, entry.name.find(' '));
+            tileUsage[kind] += entry.usage;
+            tileCounts[kind]++;
+            continue;
+        }
+        string note;
+        if(entry.references == 0) note = "UNUSED";
+        else if(entry.references > 0) note = ofToString(entry.references) + " tiles";
+        addLine(text, string(getKindName(entry.kind)) + " " + entry.name, entry.usage, note);
+    }
+    for(const auto& kind : tileUsage) {
+        addLine(text, kind.first + " tiles", kind.second, ofToString(tileCounts[kind.first]) + " tiles");
+    }
+    addLine(text, "total", getTotal(), "");
+    ofDrawBitmapStringHighlight(text.str(), x, top);
+}
+
+bool ResourceTracker::save(const string& path, const string& layoutName) const {
+    auto usageToJson = [](const Usage& usage) {
+        return ofJson{{"cpuBytes", usage.cpu}, {"gpuBytes", usage.gpu}, {"mappedBytes", usage.mapped}};
+    };
+
+    ofJson stats;
+    stats["layout"] = layoutName;
+    stats["time"] = ofGetTimestampString("%Y-%m-%d %H:%M:%S");
+    stats["total"] = usageToJson(getTotal());
+    stats["unreferencedSources"] = getNumUnreferenced();
+    stats["resources"] = ofJson::array();
+    for(const auto& entry : entries) {
+        ofJson resource = usageToJson(entry.usage);
+        resource["kind"] = getKindName(entry.kind);
+        resource["name"] = entry.name;
+        if(entry.references >= 0) {
+            resource["tiles"] = entry.references;
+        }
+        stats["resources"].push_back(resource);
+    }
+
+    if(!ofSavePrettyJson(path, stats)) {
+        ofLogError() << "Could not write resource stats to " << path;
+        return false;
+    }
+    ofLog() << "Resource stats written to " << path;
+    return true;
+}
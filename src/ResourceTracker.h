@@ -0,0 +1,63 @@
+#pragma once
+#include "ofMain.h"
+
+// Memory a layout holds, per media source, per tile and per shared pool.
+// Bytes are split into CPU pixels and buffers, GPU textures and pixel
+// buffers, and memory-mapped cache files the OS pages in and out.
+//
+// Nothing is tracked as it changes: ofApp rebuilds the table from its
+// sources now and then (see ofApp::updateResources). GPU figures come from
+// each texture's allocated size and format, so they are a lower bound on
+// what the driver really uses.
+class ResourceTracker {
+public:
+    enum Kind { VIDEO, IMAGE, CAMERA, TILE, POOL };
+
+    struct Usage {
+        uint64_t cpu = 0;
+        uint64_t gpu = 0;
+        uint64_t mapped = 0;
+
+        Usage& operator+=(const Usage& other) {
+            cpu += other.cpu;
+            gpu += other.gpu;
+            mapped += other.mapped;
+            return *this;
+        }
+    };
+
+    struct Entry {
+        Kind kind;
+        string name;
+        Usage usage;
+        int references;    // tiles drawing a source, -1 for tiles and pools
+    };
+
+    static uint64_t getBytes(const ofPixels& pixels) { return pixels.getTotalBytes(); }
+    static uint64_t getBytes(const ofTexture& texture);
+    static string formatBytes(uint64_t bytes);
+
+    void clear() { entries.clear(); }
+    void add(Kind kind, const string& name, const Usage& usage, int references = -1);
+
+    const vector<Entry>& getEntries() const { return entries; }
+    Usage getTotal() const;
+    // Sources loaded but drawn by no tile
+    size_t getNumUnreferenced() const;
+
+    bool isVisible() const { return visible; }
+    void toggle() { visible = !visible; }
+
+    // Sources and pools with their bytes, tiles summed into one line per
+    // kind, drawn downwards from the top-left corner
+    void draw(float x, float top) const;
+
+    // Every entry and the totals as JSON
+    bool save(const string& path, const string& layoutName) const;
+
+private:
+    static const char* getKindName(Kind kind);
+
+    vector<Entry> entries;
+    bool visible = false;
+};
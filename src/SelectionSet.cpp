@@ -0,0 +1,58 @@
+#include "SelectionSet.h"
+
+void SelectionSet::setBit(int index) {
+    size_t word = index >> 6;
+    if(word >= bits.size()) bits.resize(word + 1, 0);
+    bits[word] |= uint64_t(1) << (index & 63);
+}
+
+bool SelectionSet::add(int index) {
+    if(index < 0 || contains(index)) return false;
+    setBit(index);
+    order.push_back(index);
+    return true;
+}
+
+bool SelectionSet::remove(int index) {
+    if(!contains(index)) return false;
+    clearBit(index);
+    order.erase(std::find(order.begin(), order.end(), index));
+    return true;
+}
+
+void SelectionSet::clear() {
+    // Clearing only the set bits keeps small selections cheap
+    if(order.size() < bits.size()) {
+        for(int index : order) clearBit(index);
+    } else {
+        std::fill(bits.begin(), bits.end(), 0);
+    }
+    order.clear();
+}
+
+void SelectionSet::selectAll(int count) {
+    order.clear();
+    order.reserve(count);
+    bits.assign((count + 63) / 64, 0);
+    for(int i = 0; i < count; i++) {
+        order.push_back(i);
+    }
+    
+    // Whole words at once, then the partial last word
+    std::fill(bits.begin(), bits.begin() + count / 64, ~uint64_t(0));
+    if(count % 64) bits[count / 64] = (uint64_t(1) << (count % 64)) - 1;
+}
+
+void SelectionSet::eraseIndex(int index) {
+    if(index < 0) return;
+    
+    std::fill(bits.begin(), bits.end(), 0);
+    size_t kept = 0;
+    for(int selected : order) {
+        if(selected == index) continue;
+        int shifted = selected > index ? selected - 1 : selected;
+        order[kept++] = shifted;
+        setBit(shifted);
+    }
+    order.resize(kept);
+}
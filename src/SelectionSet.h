@@ -0,0 +1,37 @@
+#pragma once
+#include "ofMain.h"
+
+// Set of selected global tile indices. Membership lives in a bitset for
+// constant-time lookups while drawing; the indices are also kept in the
+// order they were selected, which group drags rely on.
+class SelectionSet {
+public:
+    bool contains(int index) const {
+        return index >= 0 && size_t(index) < bits.size() * 64 &&
+               (bits[index >> 6] >> (index & 63)) & 1;
+    }
+    
+    bool add(int index);         // false if already selected
+    bool remove(int index);      // false if not selected
+    void clear();
+    
+    // Selects every index in [0, count), used by select-all
+    void selectAll(int count);
+    
+    // A tile was deleted: drop it and shift the indices after it down by one
+    void eraseIndex(int index);
+    
+    size_t size() const { return order.size(); }
+    bool empty() const { return order.empty(); }
+    int operator[](size_t i) const { return order[i]; }
+    const vector<int>& getIndices() const { return order; }
+    vector<int>::const_iterator begin() const { return order.begin(); }
+    vector<int>::const_iterator end() const { return order.end(); }
+    
+private:
+    void setBit(int index);
+    void clearBit(int index) { bits[index >> 6] &= ~(uint64_t(1) << (index & 63)); }
+    
+    vector<uint64_t> bits;
+    vector<int> order;
+};
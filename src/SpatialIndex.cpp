@@ -0,0 +1,149 @@
+#include "SpatialIndex.h"
+
+SpatialIndex::SpatialIndex(float cellSize) : cellSize(cellSize) {
+}
+
+void SpatialIndex::clear() {
+    cells.clear();
+    rects.clear();
+    ranges.clear();
+    present.clear();
+    visited.clear();
+    numItems = 0;
+}
+
+void SpatialIndex::reserve(size_t numItems) {
+    rects.reserve(numItems);
+    ranges.reserve(numItems);
+    present.reserve(numItems);
+    cells.reserve(numItems);
+}
+
+SpatialIndex::CellRange SpatialIndex::getCellRange(const ofRectangle& rect) const {
+    // Right and bottom edges are exclusive, matching the hit test
+    CellRange range;
+    range.x0 = floor(rect.getLeft() / cellSize);
+    range.y0 = floor(rect.getTop() / cellSize);
+    range.x1 = floor((rect.getRight() - 0.001f) / cellSize);
+    range.y1 = floor((rect.getBottom() - 0.001f) / cellSize);
+    return range;
+}
+
+void SpatialIndex::addToCells(int id, const CellRange& range) {
+    for(int cy = range.y0; cy <= range.y1; cy++) {
+        for(int cx = range.x0; cx <= range.x1; cx++) {
+            cells[cellKey(cx, cy)].push_back(id);
+        }
+    }
+}
+
+void SpatialIndex::removeFromCells(int id, const CellRange& range) {
+    for(int cy = range.y0; cy <= range.y1; cy++) {
+        for(int cx = range.x0; cx <= range.x1; cx++) {
+            auto it = cells.find(cellKey(cx, cy));
+            if(it == cells.end()) continue;
+            
+            auto& ids = it->second;
+            auto found = find(ids.begin(), ids.end(), id);
+            if(found != ids.end()) {
+                *found = ids.back();
+                ids.pop_back();
+            }
+            if(ids.empty()) cells.erase(it);
+        }
+    }
+}
+
+void SpatialIndex::insert(int id, const ofRectangle& rect) {
+    if(id < 0) return;
+    if(id < (int)present.size() && present[id]) {
+        update(id, rect);
+        return;
+    }
+    if(id >= (int)present.size()) {
+        rects.resize(id + 1);
+        ranges.resize(id + 1);
+        present.resize(id + 1, false);
+    }
+    
+    rects[id] = rect;
+    ranges[id] = getCellRange(rect);
+    present[id] = true;
+    addToCells(id, ranges[id]);
+    numItems++;
+}
+
+void SpatialIndex::update(int id, const ofRectangle& rect) {
+    if(id < 0 || id >= (int)present.size() || !present[id]) {
+        insert(id, rect);
+        return;
+    }
+    
+    rects[id] = rect;
+    CellRange range = getCellRange(rect);
+    if(range == ranges[id]) return;
+    
+    removeFromCells(id, ranges[id]);
+    ranges[id] = range;
+    addToCells(id, range);
+}
+
+void SpatialIndex::remove(int id) {
+    if(id < 0 || id >= (int)present.size() || !present[id]) return;
+    removeFromCells(id, ranges[id]);
+    present[id] = false;
+    numItems--;
+}
+
+int SpatialIndex::queryPoint(float x, float y) const {
+    auto it = cells.find(cellKey(floor(x / cellSize), floor(y / cellSize)));
+    if(it == cells.end()) return -1;
+    
+    int topmost = -1;
+    for(int id : it->second) {
+        const ofRectangle& rect = rects[id];
+        if(id > topmost && x >= rect.getLeft() && x < rect.getRight() &&
+           y >= rect.getTop() && y < rect.getBottom()) {
+            topmost = id;
+        }
+    }
+    return topmost;
+}
+
+void SpatialIndex::queryRect(const ofRectangle& rect, vector<int>& result) const {
+    result.clear();
+    if(numItems == 0) return;
+    
+    if(visited.size() < present.size()) visited.resize(present.size(), 0);
+    if(++queryStamp == 0) {
+        // Stamp wrapped around, start over
+        fill(visited.begin(), visited.end(), 0);
+        queryStamp = 1;
+    }
+    
+    // Query rectangles far larger than the occupied area would visit mostly empty cells
+    CellRange range = getCellRange(rect);
+    uint64_t numCells = uint64_t(range.x1 - range.x0 + 1) * uint64_t(range.y1 - range.y0 + 1);
+    if(numCells > cells.size()) {
+        for(auto& cell : cells) {
+            for(int id : cell.second) {
+                if(visited[id] == queryStamp) continue;
+                visited[id] = queryStamp;
+                if(rects[id].intersects(rect)) result.push_back(id);
+            }
+        }
+    } else {
+        for(int cy = range.y0; cy <= range.y1; cy++) {
+            for(int cx = range.x0; cx <= range.x1; cx++) {
+                auto it = cells.find(cellKey(cx, cy));
+                if(it == cells.end()) continue;
+                for(int id : it->second) {
+                    if(visited[id] == queryStamp) continue;
+                    visited[id] = queryStamp;
+                    if(rects[id].intersects(rect)) result.push_back(id);
+                }
+            }
+        }
+    }
+    sort(result.begin(), result.end());
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "ofMain.h"
+
+// Uniform grid over tile screen rectangles. Items are identified by their
+// global tile index, which is also their draw order, so the topmost tile
+// at a point is the largest index covering it.
+//
+// Moving an item only touches the cells it leaves and enters, so drags
+// and nudges stay cheap; structural changes (deletes, loads) rebuild.
+class SpatialIndex {
+public:
+    explicit SpatialIndex(float cellSize = 160);
+    
+    void clear();
+    void reserve(size_t numItems);
+    size_t size() const { return numItems; }
+    
+    void insert(int id, const ofRectangle& rect);
+    void update(int id, const ofRectangle& rect);
+    void remove(int id);
+    
+    // Topmost item containing the point, or -1
+    int queryPoint(float x, float y) const;
+    
+    // Items intersecting the rectangle, in ascending (draw) order
+    void queryRect(const ofRectangle& rect, vector<int>& result) const;
+    
+private:
+    struct CellRange {
+        int x0 = 0, y0 = 0, x1 = -1, y1 = -1;
+        bool operator==(const CellRange& other) const {
+            return x0 == other.x0 && y0 == other.y0 && x1 == other.x1 && y1 == other.y1;
+        }
+    };
+    
+    CellRange getCellRange(const ofRectangle& rect) const;
+    static uint64_t cellKey(int cx, int cy) {
+        return (uint64_t(uint32_t(cx)) << 32) | uint32_t(cy);
+    }
+    void addToCells(int id, const CellRange& range);
+    void removeFromCells(int id, const CellRange& range);
+    
+    float cellSize;
+    unordered_map<uint64_t, vector<int>> cells;
+    vector<ofRectangle> rects;
+    vector<CellRange> ranges;
+    vector<bool> present;
+    size_t numItems = 0;
+    
+    // Per-query visit marks, so items spanning several cells are reported once
+    mutable vector<uint32_t> visited;
+    mutable uint32_t queryStamp = 0;
+};
@@ -0,0 +1,48 @@
+#include "StaticLayerCache.h"
+#include "ResourceTracker.h"
+
+bool StaticLayerCache::isValid() const {
+    return valid && fbo.isAllocated() &&
+           fbo.getWidth() == ofGetWidth() && fbo.getHeight() == ofGetHeight();
+}
+
+void StaticLayerCache::setPalette(const vector<ofColor>& colors) {
+    if(colors != palette) {
+        palette = colors;
+        valid = false;
+    }
+}
+
+void StaticLayerCache::begin() {
+    if(!fbo.isAllocated() || fbo.getWidth() != ofGetWidth() || fbo.getHeight() != ofGetHeight()) {
+        fbo.allocate(ofGetWidth(), ofGetHeight(), GL_RGBA);
+    }
+    
+    fbo.begin();
+    ofClear(0, 0, 0, 0);
+    ofPushStyle();
+    ofSetColor(255);
+    // Premultiply color while accumulating coverage in alpha
+    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+void StaticLayerCache::end() {
+    ofPopStyle();
+    fbo.end();
+    valid = true;
+    numRebuilds++;
+}
+
+void StaticLayerCache::draw() const {
+    if(!fbo.isAllocated()) return;
+    
+    ofPushStyle();
+    ofSetColor(255);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    fbo.draw(0, 0);
+    ofPopStyle();
+}
+
+uint64_t StaticLayerCache::getTextureBytes() const {
+    return fbo.isAllocated() ? ResourceTracker::getBytes(fbo.getTexture()) : 0;
+}
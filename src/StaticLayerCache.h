@@ -0,0 +1,31 @@
+#pragma once
+#include "ofMain.h"
+
+// Offscreen layer for tiles whose pixels only change when the layout is
+// edited. The layer is rendered once after each invalidation and is
+// otherwise drawn as a single screen-sized quad.
+//
+// Contents are stored premultiplied so translucent tile pixels composite
+// over the tiles beneath the layer exactly as if drawn directly.
+class StaticLayerCache {
+public:
+    void invalidate() { valid = false; }
+    bool isValid() const;
+    
+    // Invalidates the layer when the palette differs from the cached one
+    void setPalette(const vector<ofColor>& colors);
+    
+    // Redirects drawing into the layer until end()
+    void begin();
+    void end();
+    void draw() const;
+    
+    size_t getNumRebuilds() const { return numRebuilds; }
+    uint64_t getTextureBytes() const;
+    
+private:
+    ofFbo fbo;
+    vector<ofColor> palette;
+    bool valid = false;
+    size_t numRebuilds = 0;
+};
@@ -0,0 +1,63 @@
+#include "SwatchExtractor.h"
+
+vector<ofColor> SwatchExtractor::extract(const ofPixels& smallPixels, int numSwatches) {
+    // Extract colors as HSV
+    vector<ofVec3f> colors;
+    for(size_t y = 0; y < smallPixels.getHeight(); y++) {
+        for(size_t x = 0; x < smallPixels.getWidth(); x++) {
+            ofColor c = smallPixels.getColor(x, y);
+            float hue, sat, val;
+            c.getHsb(hue, sat, val);
+            colors.push_back(ofVec3f(hue, sat, val));
+        }
+    }
+    
+    // K-means clustering
+    vector<ofVec3f> centroids = colors;
+    random_shuffle(centroids.begin(), centroids.end());
+    centroids.resize(numSwatches);
+    
+    vector<vector<ofVec3f>> clusters(numSwatches);
+    for(const auto& color : colors) {
+        float minDist = FLT_MAX;
+        int closestCentroid = 0;
+        
+        for(int i = 0; i < numSwatches; i++) {
+            float dist = (color - centroids[i]).length();
+            if(dist < minDist) {
+                minDist = dist;
+                closestCentroid = i;
+            }
+        }
+        
+        clusters[closestCentroid].push_back(color);
+    }
+    
+    // Calculate new colors
+    vector<ofColor> newColors(numSwatches);
+    for(int i = 0; i < numSwatches; i++) {
+        if(!clusters[i].empty()) {
+            ofVec3f sum(0, 0, 0);
+            for(const auto& color : clusters[i]) {
+                sum += color;
+            }
+            ofVec3f centroid = sum / clusters[i].size();
+            
+            newColors[i].setHsb(
+                centroid.x,
+                centroid.y,
+                centroid.z
+            );
+        }
+    }
+    
+    // Sort colors by brightness (value component)
+    sort(newColors.begin(), newColors.end(), [](const ofColor& a, const ofColor& b) {
+        float ha, sa, va, hb, sb, vb;
+        a.getHsb(ha, sa, va);
+        b.getHsb(hb, sb, vb);
+        return va > vb; // Sort descending (brightest first)
+    });
+    
+    return newColors;
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include "ofMain.h"
+
+// Palette extraction for color-input tiles: one k-means pass over the HSB
+// values of a downscaled frame, brightest swatch first.
+class SwatchExtractor {
+public:
+    static vector<ofColor> extract(const ofPixels& smallPixels, int numSwatches);
+};
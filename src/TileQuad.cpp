@@ -0,0 +1,61 @@
+#include "TileQuad.h"
+
+TileQuad::TileQuad(const ofRectangle& rect) : TileQuad({{
+    glm::vec2(rect.getLeft(), rect.getTop()),
+    glm::vec2(rect.getRight(), rect.getTop()),
+    glm::vec2(rect.getRight(), rect.getBottom()),
+    glm::vec2(rect.getLeft(), rect.getBottom())
+}}, BILINEAR) {
+}
+
+TileQuad::TileQuad(const array<glm::vec2, 4>& newCorners, Mapping newMapping)
+    : corners(newCorners), mapping(newMapping) {
+    if(mapping != PERSPECTIVE) return;
+
+    const glm::vec2& p0 = corners[0];
+    const glm::vec2& p1 = corners[1];
+    const glm::vec2& p2 = corners[2];
+    const glm::vec2& p3 = corners[3];
+    glm::vec2 sum = p0 - p1 + p2 - p3;
+    glm::vec2 d1 = p1 - p2;
+    glm::vec2 d2 = p3 - p2;
+    float det = d1.x * d2.y - d2.x * d1.y;
+    if(sum == glm::vec2(0) || fabs(det) < 1e-6f) {
+        // A parallelogram, or degenerate: the mapping is affine
+        g = h = 0;
+    } else {
+        g = (sum.x * d2.y - d2.x * sum.y) / det;
+        h = (d1.x * sum.y - sum.x * d1.y) / det;
+    }
+    a = p1.x - p0.x + g * p1.x;
+    b = p3.x - p0.x + h * p3.x;
+    c = p0.x;
+    d = p1.y - p0.y + g * p1.y;
+    e = p3.y - p0.y + h * p3.y;
+    f = p0.y;
+}
+
+bool TileQuad::isRectangle() const {
+    return corners[0].y == corners[1].y && corners[1].x == corners[2].x &&
+           corners[2].y == corners[3].y && corners[3].x == corners[0].x;
+}
+
+ofRectangle TileQuad::getBounds() const {
+    glm::vec2 low = corners[0];
+    glm::vec2 high = corners[0];
+    for(const auto& corner : corners) {
+        low = glm::min(low, corner);
+        high = glm::max(high, corner);
+    }
+    return ofRectangle(low.x, low.y, high.x - low.x, high.y - low.y);
+}
+
+glm::vec2 TileQuad::getPoint(float u, float v) const {
+    if(mapping == PERSPECTIVE) {
+        float w = g * u + h * v + 1;
+        return glm::vec2((a * u + b * v + c) / w, (d * u + e * v + f) / w);
+    }
+    glm::vec2 top = glm::mix(corners[0], corners[1], u);
+    glm::vec2 bottom = glm::mix(corners[3], corners[2], u);
+    return glm::mix(top, bottom, v);
+}
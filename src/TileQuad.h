@@ -0,0 +1,32 @@
+#pragma once
+#include "ofMain.h"
+
+// Where a tile lands on screen: four corners clockwise from the top-left.
+// Corners that are not an axis-aligned rectangle warp the tile across
+// them, either bilinearly or with a perspective (homography) mapping.
+class TileQuad {
+public:
+    enum Mapping { BILINEAR, PERSPECTIVE };
+
+    TileQuad() = default;
+    explicit TileQuad(const ofRectangle& rect);
+    TileQuad(const array<glm::vec2, 4>& corners, Mapping mapping);
+
+    const glm::vec2& operator[](size_t corner) const { return corners[corner]; }
+    // Axis aligned, so nothing to warp
+    bool isRectangle() const;
+    ofRectangle getBounds() const;
+
+    // Point at (u, v) across the tile, both 0 to 1
+    glm::vec2 getPoint(float u, float v) const;
+
+private:
+    array<glm::vec2, 4> corners = {{glm::vec2(0), glm::vec2(0), glm::vec2(0), glm::vec2(0)}};
+    Mapping mapping = BILINEAR;
+
+    // Unit square to quad homography, x = (au + bv + c) / (gu + hv + 1)
+    // and y = (du + ev + f) / (gu + hv + 1)
+    float a = 1, b = 0, c = 0;
+    float d = 0, e = 1, f = 0;
+    float g = 0, h = 0;
+};
@@ -0,0 +1,224 @@
+#include "TileRenderer.h"
+#include "BaseElement.h"
+#include "ColorRemap.h"
+
+// Per-vertex tile parameters:
+//   color  = palette coordinates of both remap colors, remap flag
+//   normal = gradient coordinates, gradient flag
+// The gradient is blended into the tile color with the same weights the
+// old alpha-blended overlay quad used.
+static const string FRAGMENT_BODY_GL2 = R"(
+uniform SAMPLER source;
+uniform sampler2D palette;
+uniform sampler2D gradient;
+uniform float gradientStrength;
+
+varying vec4 tileParams;
+varying vec3 gradientCoord;
+
+void main() {
+    vec4 color = TEXTURE(source, gl_TexCoord[0].xy);
+    if(tileParams.z > 0.5) {
+        float luma = dot(color.rgb, vec3(0.299, 0.587, 0.114));
+        vec3 c1 = texture2D(palette, vec2(tileParams.x, 0.5)).rgb;
+        vec3 c2 = texture2D(palette, vec2(tileParams.y, 0.5)).rgb;
+        color = vec4(mix(c1, c2, luma), 1.0);
+    }
+    vec4 g = texture2D(gradient, gradientCoord.xy);
+    color.rgb = mix(color.rgb, g.rgb, g.a * gradientStrength * gradientCoord.z);
+    gl_FragColor = color;
+}
+)";
+
+static const string VERTEX_GL2 = R"(#version 120
+varying vec4 tileParams;
+varying vec3 gradientCoord;
+
+void main() {
+    gl_TexCoord[0] = gl_MultiTexCoord0;
+    tileParams = gl_Color;
+    gradientCoord = gl_Normal;
+    gl_Position = ftransform();
+}
+)";
+
+static const string FRAGMENT_BODY_GL3 = R"(
+uniform SAMPLER source;
+uniform sampler2D palette;
+uniform sampler2D gradient;
+uniform float gradientStrength;
+
+in vec2 texCoordVarying;
+in vec4 tileParams;
+in vec3 gradientCoord;
+out vec4 fragColor;
+
+void main() {
+    vec4 color = texture(source, texCoordVarying);
+    if(tileParams.z > 0.5) {
+        float luma = dot(color.rgb, vec3(0.299, 0.587, 0.114));
+        vec3 c1 = texture(palette, vec2(tileParams.x, 0.5)).rgb;
+        vec3 c2 = texture(palette, vec2(tileParams.y, 0.5)).rgb;
+        color = vec4(mix(c1, c2, luma), 1.0);
+    }
+    vec4 g = texture(gradient, gradientCoord.xy);
+    color.rgb = mix(color.rgb, g.rgb, g.a * gradientStrength * gradientCoord.z);
+    fragColor = color;
+}
+)";
+
+static const string VERTEX_GL3 = R"(#version 150
+uniform mat4 modelViewProjectionMatrix;
+in vec4 position;
+in vec4 color;
+in vec3 normal;
+in vec2 texcoord;
+out vec2 texCoordVarying;
+out vec4 tileParams;
+out vec3 gradientCoord;
+
+void main() {
+    texCoordVarying = texcoord;
+    tileParams = color;
+    gradientCoord = normal;
+    gl_Position = modelViewProjectionMatrix * position;
+}
+)";
+
+bool TileRenderer::setup() {
+    bool programmable = ofIsGLProgrammableRenderer();
+    string version = programmable ? "#version 150\n"
+                                  : "#version 120\n#extension GL_ARB_texture_rectangle : enable\n";
+
+    auto build = [&](ofShader& shader, bool rectangle) {
+        string defines = rectangle
+            ? "#define SAMPLER sampler2DRect\n#define TEXTURE texture2DRect\n"
+            : "#define SAMPLER sampler2D\n#define TEXTURE texture2D\n";
+        string fragment = version + defines + (programmable ? FRAGMENT_BODY_GL3 : FRAGMENT_BODY_GL2);
+
+        if(!shader.setupShaderFromSource(GL_VERTEX_SHADER, programmable ? VERTEX_GL3 : VERTEX_GL2)) return false;
+        if(!shader.setupShaderFromSource(GL_FRAGMENT_SHADER, fragment)) return false;
+        if(programmable) shader.bindDefaults();
+        return shader.linkProgram();
+    };
+
+    available = build(rectShader, true) && build(shader2D, false);
+    if(available) {
+        ofLog() << "Batched tile pass ready";
+    } else {
+        ofLog() << "Batched tile pass unavailable, drawing tiles one by one";
+    }
+    return available;
+}
+
+const ofShader& TileRenderer::getShader(const ofTexture& texture) const {
+    return texture.getTextureData().textureTarget == GL_TEXTURE_2D ? shader2D : rectShader;
+}
+
+void TileRenderer::begin() {
+    // Meshes are kept between frames so their storage is reused
+    for(size_t i = 0; i < numBatches; i++) {
+        batches[i].mesh.clear();
+        batches[i].texture = nullptr;
+    }
+    numBatches = 0;
+}
+
+void TileRenderer::add(const ofTexture& texture, const ofRectangle& target, const ofRectangle& region,
+                       bool remap, int colorIndex1, int colorIndex2, bool gradient) {
+    add(texture, TileQuad(target), region, remap, colorIndex1, colorIndex2, gradient);
+}
+
+void TileRenderer::add(const ofTexture& texture, const TileQuad& target, const ofRectangle& region,
+                       bool remap, int colorIndex1, int colorIndex2, bool gradient) {
+    if(!texture.isAllocated()) return;
+
+    // Start a new batch whenever the source texture changes
+    if(numBatches == 0 ||
+       batches[numBatches - 1].texture->getTextureData().textureID != texture.getTextureData().textureID) {
+        if(numBatches == batches.size()) {
+            batches.emplace_back();
+            batches.back().mesh.setMode(OF_PRIMITIVE_TRIANGLES);
+        }
+        batches[numBatches].texture = &texture;
+        numBatches++;
+    }
+    ofMesh& mesh = batches[numBatches - 1].mesh;
+
+    float paletteSize = max<size_t>(ColorRemap::getPaletteSize(), 1);
+    ofFloatColor params((colorIndex1 + 0.5f) / paletteSize, (colorIndex2 + 0.5f) / paletteSize,
+                        remap ? 1.0f : 0.0f, 1.0f);
+    float gradientFlag = gradient ? 1.0f : 0.0f;
+
+    // A plain rectangle is one quad. A warped one is a grid of quads placed
+    // along the warp, so the mapping holds inside the tile and not only at
+    // its corners; it stays in the same batch either way.
+    int steps = target.isRectangle() ? 1 : WARP_GRID;
+    unsigned int first = mesh.getNumVertices();
+    for(int j = 0; j <= steps; j++) {
+        float v = float(j) / steps;
+        for(int i = 0; i <= steps; i++) {
+            float u = float(i) / steps;
+            mesh.addVertex(glm::vec3(target.getPoint(u, v), 0));
+            mesh.addTexCoord(texture.getCoordFromPoint(region.x + u * region.width, region.y + v * region.height));
+            mesh.addNormal(glm::vec3(u, v, gradientFlag));
+            mesh.addColor(params);
+        }
+    }
+
+    for(int j = 0; j < steps; j++) {
+        for(int i = 0; i < steps; i++) {
+            unsigned int topLeft = first + j * (steps + 1) + i;
+            unsigned int bottomLeft = topLeft + steps + 1;
+            mesh.addIndex(topLeft);
+            mesh.addIndex(topLeft + 1);
+            mesh.addIndex(bottomLeft + 1);
+            mesh.addIndex(topLeft);
+            mesh.addIndex(bottomLeft + 1);
+            mesh.addIndex(bottomLeft);
+        }
+    }
+}
+
+void TileRenderer::end() {
+    bool gradientVisible = BaseElement::isGradientVisible();
+    const ofShader* current = nullptr;
+
+    ofPushStyle();
+    ofSetColor(255);
+    for(size_t i = 0; i < numBatches; i++) {
+        const Batch& batch = batches[i];
+        const ofShader& shader = getShader(*batch.texture);
+
+        // Palette and gradient stay bound across batches using the same shader
+        if(&shader != current) {
+            if(current) current->end();
+            current = &shader;
+            shader.begin();
+            if(ColorRemap::getPaletteTexture().isAllocated()) {
+                shader.setUniformTexture("palette", ColorRemap::getPaletteTexture(), 1);
+            }
+            if(gradientVisible) {
+                shader.setUniformTexture("gradient", BaseElement::gradientTexture, 2);
+            }
+            shader.setUniform1f("gradientStrength", gradientVisible ? BaseElement::gradientStrength : 0.0f);
+        }
+
+        shader.setUniformTexture("source", *batch.texture, 0);
+        batch.mesh.draw();
+    }
+    if(current) current->end();
+    ofPopStyle();
+}
+
+size_t TileRenderer::getMeshBytes() const {
+    size_t bytes = 0;
+    for(const auto& batch : batches) {
+        bytes += batch.mesh.getVertices().capacity() * sizeof(glm::vec3) +
+                 batch.mesh.getTexCoords().capacity() * sizeof(glm::vec2) +
+                 batch.mesh.getNormals().capacity() * sizeof(glm::vec3) +
+                 batch.mesh.getColors().capacity() * sizeof(ofFloatColor) +
+                 batch.mesh.getIndices().capacity() * sizeof(ofIndexType);
+    }
+    return bytes;
+}
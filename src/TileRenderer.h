@@ -0,0 +1,43 @@
+#pragma once
+#include "ofMain.h"
+#include "TileQuad.h"
+
+// Batched tile pass. Tiles are queued as textured quads and consecutive
+// tiles sharing a source texture are drawn as one mesh, which keeps the
+// painter's order of the layout while collapsing draw calls.
+//
+// The fragment shader applies the color-input remap and multiplies the
+// gradient overlay into the same pass, so neither needs a second draw.
+class TileRenderer {
+public:
+    bool setup();
+    bool isAvailable() const { return available; }
+
+    void begin();
+    void add(const ofTexture& texture, const ofRectangle& target, const ofRectangle& region,
+             bool remap = false, int colorIndex1 = 0, int colorIndex2 = 0, bool gradient = true);
+    // Same, drawn across a possibly warped quad
+    void add(const ofTexture& texture, const TileQuad& target, const ofRectangle& region,
+             bool remap = false, int colorIndex1 = 0, int colorIndex2 = 0, bool gradient = true);
+    void end();
+
+    size_t getNumDrawCalls() const { return numBatches; }
+    // CPU side of the batch meshes, kept between frames
+    size_t getMeshBytes() const;
+
+private:
+    static const int WARP_GRID = 8;   // quads per side for a warped tile
+
+    struct Batch {
+        const ofTexture* texture = nullptr;
+        ofMesh mesh;
+    };
+
+    const ofShader& getShader(const ofTexture& texture) const;
+
+    ofShader rectShader;     // sources in rectangle textures
+    ofShader shader2D;       // sources in normalized 2D textures
+    vector<Batch> batches;
+    size_t numBatches = 0;
+    bool available = false;
+};
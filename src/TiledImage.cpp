@@ -0,0 +1,199 @@
+#include "TiledImage.h"
+
+size_t TiledImage::maxResidentBytes = 256 << 20;
+uint64_t TiledImage::useCounter = 0;
+
+static const char* CACHE_DIRECTORY = "cache/tiles";
+static const char MAGIC[8] = {'T', 'I', 'L', 'E', 'I', 'M', 'G', '1'};
+
+static ofPixelFormat formatFromChannels(int channels) {
+    return channels == 1 ? OF_PIXELS_GRAY : channels == 4 ? OF_PIXELS_RGBA : OF_PIXELS_RGB;
+}
+
+bool TiledImage::load(const string& path) {
+    clear();
+
+    string imagePath = ofToDataPath(path, true);
+    string name = MappedFile::getCacheName(imagePath, ofToString(PAGE_SIZE));
+    if(name.empty()) {
+        ofLogError() << "Image not found: " << path;
+        return false;
+    }
+    string directory = ofToDataPath(CACHE_DIRECTORY, true);
+    ofDirectory dir(directory);
+    if(!dir.exists()) {
+        dir.create(true);
+    }
+
+    string cachePath = ofFilePath::join(directory, name + ".tiles");
+    if(openCache(cachePath)) return true;
+    return build(imagePath, cachePath) && openCache(cachePath);
+}
+
+void TiledImage::clear() {
+    resident.clear();
+    file.close();
+    width = height = channels = pagesX = 0;
+}
+
+bool TiledImage::build(const string& imagePath, const string& cachePath) {
+    // The one full decode; pages are cut from it and it is dropped again
+    ofPixels pixels;
+    if(!ofLoadImage(pixels, imagePath)) return false;
+    if(pixels.getNumChannels() == 2) {
+        pixels.setImageType(OF_IMAGE_COLOR_ALPHA);
+    }
+
+    Header header = {};
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.width = pixels.getWidth();
+    header.height = pixels.getHeight();
+    header.channels = pixels.getNumChannels();
+    header.pageSize = PAGE_SIZE;
+    ofLog() << "Tiling " << ofFilePath::getFileName(imagePath) << " (" << header.width << "x" << header.height << ")";
+
+    // Written under a temporary name so a cut-short build is never mapped
+    string tempPath = cachePath + ".tmp";
+    FILE* out = fopen(tempPath.c_str(), "wb");
+    if(!out) {
+        ofLogError() << "Could not write " << tempPath;
+        return false;
+    }
+    vector<unsigned char> page(HEADER_SIZE, 0);
+    memcpy(page.data(), &header, sizeof(header));
+    bool ok = fwrite(page.data(), 1, HEADER_SIZE, out) == HEADER_SIZE;
+
+    // Edge pages are padded to full size so every page has the same layout
+    size_t rowBytes = PAGE_SIZE * header.channels;
+    page.assign(rowBytes * PAGE_SIZE, 0);
+    for(uint32_t py = 0; ok && py < header.height; py += PAGE_SIZE) {
+        for(uint32_t px = 0; ok && px < header.width; px += PAGE_SIZE) {
+            fill(page.begin(), page.end(), 0);
+            size_t copyBytes = min<uint32_t>(PAGE_SIZE, header.width - px) * header.channels;
+            for(uint32_t y = 0; y < PAGE_SIZE && py + y < header.height; y++) {
+                const unsigned char* row = pixels.getData() + (size_t(py + y) * header.width + px) * header.channels;
+                memcpy(page.data() + y * rowBytes, row, copyBytes);
+            }
+            ok = fwrite(page.data(), 1, page.size(), out) == page.size();
+        }
+    }
+    ok = fclose(out) == 0 && ok;
+
+    if(ok && rename(tempPath.c_str(), cachePath.c_str()) == 0) {
+        return true;
+    }
+    ofLogError() << "Could not write tiled image cache " << cachePath;
+    ofFile::removeFile(tempPath, false);
+    return false;
+}
+
+bool TiledImage::openCache(const string& path) {
+    if(!file.open(path)) return false;
+
+    Header header;
+    bool valid = file.size() >= HEADER_SIZE;
+    if(valid) {
+        memcpy(&header, file.getData(), sizeof(header));
+        size_t columns = (header.width + PAGE_SIZE - 1) / PAGE_SIZE;
+        size_t rows = (header.height + PAGE_SIZE - 1) / PAGE_SIZE;
+        valid = memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 && header.pageSize == PAGE_SIZE &&
+                (header.channels == 1 || header.channels == 3 || header.channels == 4) &&
+                HEADER_SIZE + columns * rows * PAGE_SIZE * PAGE_SIZE * header.channels == file.size();
+    }
+    if(!valid) {
+        ofLogWarning() << "Discarding invalid tiled image cache " << path;
+        file.close();
+        ofFile::removeFile(path, false);
+        return false;
+    }
+
+    width = header.width;
+    height = header.height;
+    channels = header.channels;
+    pagesX = (width + PAGE_SIZE - 1) / PAGE_SIZE;
+    MappedFile::touch(path);
+    return true;
+}
+
+void TiledImage::getRegionPixels(const ofRectangle& region, ofPixels& pixels) const {
+    int regionX = region.x;
+    int regionY = region.y;
+    int regionWidth = max(1, int(region.width));
+    int regionHeight = max(1, int(region.height));
+    pixels.allocate(regionWidth, regionHeight, formatFromChannels(channels));
+    pixels.set(0);
+    if(!file.isOpen()) return;
+
+    size_t pageBytes = size_t(PAGE_SIZE) * PAGE_SIZE * channels;
+    int x0 = max(regionX, 0);
+    int x1 = min(regionX + regionWidth, width);
+    for(int y = max(regionY, 0); y < min(regionY + regionHeight, height); y++) {
+        // Each row of the region crosses one or more pages
+        for(int x = x0; x < x1; ) {
+            int pageX = x / PAGE_SIZE;
+            int pageY = y / PAGE_SIZE;
+            int run = min(x1, (pageX + 1) * PAGE_SIZE) - x;
+            const unsigned char* page = file.getData() + HEADER_SIZE + (size_t(pageY) * pagesX + pageX) * pageBytes;
+            const unsigned char* source = page + (size_t(y % PAGE_SIZE) * PAGE_SIZE + x % PAGE_SIZE) * channels;
+            unsigned char* destination = pixels.getData() +
+                (size_t(y - regionY) * regionWidth + (x - regionX)) * channels;
+            memcpy(destination, source, size_t(run) * channels);
+            x += run;
+        }
+    }
+}
+
+const ofTexture& TiledImage::getRegionTexture(const ofRectangle& region) {
+    auto key = make_tuple(int(region.x), int(region.y), int(region.width), int(region.height));
+    Region& entry = resident[key];
+    entry.lastUsed = ++useCounter;
+    if(!entry.texture.isAllocated()) {
+        ofPixels pixels;
+        getRegionPixels(region, pixels);
+        entry.texture.loadData(pixels);
+        entry.bytes = pixels.getTotalBytes();
+    }
+    return entry.texture;
+}
+
+size_t TiledImage::getResidentBytes() const {
+    size_t bytes = 0;
+    for(const auto& entry : resident) {
+        bytes += entry.second.bytes;
+    }
+    return bytes;
+}
+
+ResourceTracker::Usage TiledImage::getMemoryUsage() const {
+    ResourceTracker::Usage usage;
+    usage.gpu = getResidentBytes();
+    usage.mapped = file.size();
+    return usage;
+}
+
+void TiledImage::trim(vector<TiledImage>& images) {
+    struct Candidate {
+        TiledImage* image;
+        tuple<int, int, int, int> key;
+        uint64_t lastUsed;
+        size_t bytes;
+    };
+    vector<Candidate> candidates;
+    size_t total = 0;
+    for(auto& image : images) {
+        for(const auto& entry : image.resident) {
+            candidates.push_back({&image, entry.first, entry.second.lastUsed, entry.second.bytes});
+            total += entry.second.bytes;
+        }
+    }
+    if(total <= maxResidentBytes) return;
+
+    sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        return a.lastUsed < b.lastUsed;
+    });
+    for(const auto& candidate : candidates) {
+        if(total <= maxResidentBytes) break;
+        candidate.image->resident.erase(candidate.key);
+        total -= candidate.bytes;
+    }
+}
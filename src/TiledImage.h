@@ -0,0 +1,72 @@
+#pragma once
+#include "ofMain.h"
+#include "MappedFile.h"
+#include "ResourceTracker.h"
+
+// A still image kept as a tiled raw file on local disk and memory mapped, so
+// images far past the texture size limit and RAM can back tiles.
+//
+// The first load decodes the image once and writes data/cache/tiles/<key>.tiles:
+// a page-aligned header, then PAGE_SIZE square pages row by row. Later loads
+// map that file and never decode. The key hashes the image's path, time and
+// size like LoopFrameCache, so an edited image is cached again.
+//
+// GPU textures exist only for the regions tiles draw. They are made on first
+// use and stay valid at least until the next trim(), which drops the least
+// recently used ones past maxResidentBytes across all images.
+class TiledImage {
+public:
+    static const int PAGE_SIZE = 256;
+    static size_t maxResidentBytes;     // 256 MB by default
+
+    bool load(const string& path);
+    void clear();
+
+    bool isAllocated() const { return file.isOpen(); }
+    float getWidth() const { return width; }
+    float getHeight() const { return height; }
+
+    // Pixels of a region, read from the mapped pages. Parts of the region
+    // outside the image are transparent black.
+    void getRegionPixels(const ofRectangle& region, ofPixels& pixels) const;
+
+    // Texture holding exactly the region, created on demand
+    const ofTexture& getRegionTexture(const ofRectangle& region);
+
+    size_t getResidentBytes() const;
+    size_t getNumResident() const { return resident.size(); }
+    // Mapped pages and resident region textures
+    ResourceTracker::Usage getMemoryUsage() const;
+
+    // Drops the least recently used region textures of all images until
+    // they fit the cap. Call between frames.
+    static void trim(vector<TiledImage>& images);
+
+private:
+    struct Header {
+        char magic[8];
+        uint32_t width;
+        uint32_t height;
+        uint32_t channels;
+        uint32_t pageSize;
+    };
+    static const size_t HEADER_SIZE = 4096;
+
+    struct Region {
+        ofTexture texture;
+        size_t bytes = 0;
+        uint64_t lastUsed = 0;
+    };
+
+    static bool build(const string& imagePath, const string& cachePath);
+    bool openCache(const string& path);
+
+    MappedFile file;
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    int pagesX = 0;
+    map<tuple<int, int, int, int>, Region> resident;
+
+    static uint64_t useCounter;
+};
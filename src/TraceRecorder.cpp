@@ -0,0 +1,87 @@
+#include "TraceRecorder.h"
+
+std::atomic<bool> TraceRecorder::recording{false};
+std::mutex TraceRecorder::mutex;
+vector<TraceRecorder::Event> TraceRecorder::events;
+size_t TraceRecorder::numEvents = 0;
+int64_t TraceRecorder::startTime = 0;
+map<int, string> TraceRecorder::threadNames;
+
+int TraceRecorder::getThreadId() {
+    static std::atomic<int> nextId{1};
+    thread_local int id = nextId++;
+    return id;
+}
+
+void TraceRecorder::start() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if(recording) return;
+
+    events.resize(MAX_EVENTS);
+    numEvents = 0;
+    startTime = now();
+    recording = true;
+    ofLog() << "Trace recording started";
+}
+
+void TraceRecorder::setThreadName(const string& name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    threadNames[getThreadId()] = name;
+}
+
+void TraceRecorder::add(const char* name, int64_t startMicros) {
+    int64_t end = now();
+    int thread = getThreadId();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if(!recording) return;
+    events[numEvents % MAX_EVENTS] = {name, startMicros - startTime, int32_t(end - startMicros), thread};
+    numEvents++;
+}
+
+string TraceRecorder::stop() {
+    vector<Event> recorded;
+    size_t count;
+    map<int, string> names;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(!recording) return "";
+        recording = false;
+        recorded.swap(events);
+        count = numEvents;
+        names = threadNames;
+    }
+    if(count == 0) {
+        ofLog() << "Trace recording stopped, no events";
+        return "";
+    }
+
+    ofDirectory dir("traces");
+    if(!dir.exists()) {
+        dir.create();
+    }
+    string path = "traces/trace-" + ofGetTimestampString("%Y%m%d-%H%M%S") + ".json";
+
+    // Events are written by hand, going through ofJson would double the
+    // memory of a full ring
+    ofstream file(ofToDataPath(path));
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"HainanProjectionMapping\"}}";
+    for(const auto& thread : names) {
+        file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread.first
+             << ",\"args\":{\"name\":\"" << thread.second << "\"}}";
+    }
+    size_t first = count > MAX_EVENTS ? count - MAX_EVENTS : 0;
+    for(size_t i = first; i < count; i++) {
+        const Event& event = recorded[i % MAX_EVENTS];
+        file << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+             << ",\"ts\":" << event.start << ",\"dur\":" << event.duration << "}";
+    }
+    file << "\n]}\n";
+
+    ofLog() << "Trace recording stopped, wrote " << (count - first) << " events to " << path;
+    if(first > 0) {
+        ofLog() << "Trace ring was full, the oldest " << first << " events were dropped";
+    }
+    return path;
+}
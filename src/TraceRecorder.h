@@ -0,0 +1,73 @@
+#pragma once
+#include "ofMain.h"
+#include <atomic>
+#include <chrono>
+
+// Records timed events from any thread into a fixed-size ring and writes
+// them as Chrome Trace Event JSON, which chrome://tracing and Perfetto open.
+// Once the ring is full the oldest events are overwritten, so a long
+// recording keeps its last MAX_EVENTS events.
+//
+// Event names must be string literals; only the pointer is stored.
+class TraceRecorder {
+public:
+    static const size_t MAX_EVENTS = 1 << 19;   // about 12 MB while recording
+
+    static void start();
+    // Writes the recording to traces/ and returns the file path, or "" if
+    // nothing was recorded
+    static string stop();
+    static void toggle() { if(isRecording()) stop(); else start(); }
+    static bool isRecording() { return recording.load(std::memory_order_relaxed); }
+
+    // Names the calling thread in the trace
+    static void setThreadName(const string& name);
+
+    // Microseconds on the trace clock
+    static int64_t now() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Adds an event that started at startMicros and ends now
+    static void add(const char* name, int64_t startMicros);
+
+private:
+    struct Event {
+        const char* name;
+        int64_t start;
+        int32_t duration;
+        int32_t thread;
+    };
+
+    static int getThreadId();
+
+    static std::atomic<bool> recording;
+    static std::mutex mutex;
+    static vector<Event> events;
+    static size_t numEvents;           // total added, the ring holds the last MAX_EVENTS
+    static int64_t startTime;
+    static map<int, string> threadNames;
+};
+
+// Traces the rest of the enclosing block; safe on any thread
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) : name(name), start(TraceRecorder::isRecording() ? TraceRecorder::now() : -1) {}
+    ~TraceScope() {
+        if(start >= 0) TraceRecorder::add(name, start);
+    }
+
+private:
+    const char* name;
+    int64_t start;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#ifdef TILE_PROFILER
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+#else
+#define TRACE_SCOPE(name)
+#endif
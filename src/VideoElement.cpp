@@ -1,4 +1,6 @@
 #include "VideoElement.h"
+#include "ColorRemap.h"
+#include "Profiler.h"
 
 VideoElement::VideoElement() {
     offsetX = offsetY = 0;
@@ -13,68 +15,71 @@ void VideoElement::update() {
 }
 
 
-void VideoElement::draw(const vector<ofVideoPlayer>& videos, const vector<ofColor>& colorSwatches, bool isEditMode, int index) {
+void VideoElement::draw(const vector<VideoSource>& videos, const vector<ofColor>& colorSwatches) {
+    PROFILE_SCOPE("tile draw");
     if(videoIndex >= videos.size()) return;
     
     const auto& video = videos[videoIndex];
     if(!video.isLoaded()) return;
     
-    ofPushMatrix();
-    ofTranslate(x + offsetX, y + offsetY);
+    ofRectangle target = getTargetRect();
     
     if(useColorInput && colorSwatches.size() > max(colorIndex1, colorIndex2)) {
-        // Get the video frame pixels for our region
-        ofPixels videoPixels = video.getPixels();
-        ofPixels regionPixels;
-        videoPixels.cropTo(regionPixels, 
-            sourceRegion.x, sourceRegion.y, 
-            sourceRegion.width, sourceRegion.height);
-        
-        // Process pixels directly like ImageElement does
-        for(size_t i = 0; i < regionPixels.size(); i += regionPixels.getNumChannels()) {
-            float r = regionPixels[i];
-            float g = regionPixels[i + 1];
-            float b = regionPixels[i + 2];
-            
-            // Calculate brightness using perceived luminance weights
-            float brightness = (0.299f * r + 0.587f * g + 0.114f * b) / 255.0f;
-            
-            // Interpolate between colors based on brightness
-            ofColor result = colorSwatches[colorIndex1].getLerped(colorSwatches[colorIndex2], brightness);
-            
-            regionPixels[i] = result.r;
-            regionPixels[i + 1] = result.g;
-            regionPixels[i + 2] = result.b;
+        if(ColorRemap::isShaderEnabled() && !video.isLumaOnly()) {
+            // Remap on the GPU straight from the video texture
+            ColorRemap::drawSubsection(video.getTexture(), target, sourceRegion, colorIndex1, colorIndex2);
+            drawGradient(target);
+        } else {
+            // CPU reference path, gradient is baked in
+            remapOnCpu(video, colorSwatches).draw(target);
         }
-        
-        ofTexture tex;
-        tex.loadData(regionPixels);
-        tex.draw(0, 0, TILE_SIZE, TILE_SIZE);
     } else {
         // Draw normal video segment
-        video.getTexture().drawSubsection(0, 0, TILE_SIZE, TILE_SIZE,
+        video.getTexture().drawSubsection(target.x, target.y, target.width, target.height,
                                         sourceRegion.x, sourceRegion.y,
                                         sourceRegion.width, sourceRegion.height);
+        drawGradient(target);
     }
+}
+
+void VideoElement::addToBatch(TileRenderer& renderer, const vector<VideoSource>& videos, 
+                              const vector<ofColor>& colorSwatches) {
+    PROFILE_SCOPE("tile batch");
+    if(videoIndex >= videos.size()) return;
     
-    // Draw gradient overlay if enabled
-    if(showGradient && gradientTexture.isAllocated()) {
-        gradientTexture.draw(0, 0, TILE_SIZE, TILE_SIZE);
-    }
-    
-    ofPopMatrix();
+    const auto& video = videos[videoIndex];
+    if(!video.isLoaded()) return;
     
-    // Draw index if in edit mode
-    if(isEditMode) {
-        if(isPrimary()) {
-            // Draw primary indicator in red with asterisk
-            ofSetColor(255, 0, 0);  // Red color
-            ofDrawBitmapStringHighlight(ofToString(index) + " *", x + 5, y + 15, ofColor(255, 0, 0), ofColor(0));
-            ofSetColor(255);  // Reset color
+    if(useColorInput && colorSwatches.size() > max(colorIndex1, colorIndex2)) {
+        if(ColorRemap::isShaderEnabled() && !video.isLumaOnly()) {
+            renderer.add(video.getTexture(), getTargetQuad(), sourceRegion, true, colorIndex1, colorIndex2);
         } else {
-            // Draw normal index
-            ofDrawBitmapStringHighlight(ofToString(index), x + 5, y + 15);
+            const ofTexture& remapped = remapOnCpu(video, colorSwatches);
+            renderer.add(remapped, getTargetQuad(), ofRectangle(0, 0, remapped.getWidth(), remapped.getHeight()),
+                         false, 0, 0, false);
         }
+    } else {
+        renderer.add(video.getTexture(), getTargetQuad(), sourceRegion);
+    }
+}
+
+const ofTexture& VideoElement::remapOnCpu(const VideoSource& video, const vector<ofColor>& colorSwatches) const {
+    PROFILE_SCOPE("cpu remap");
+    ofPixels regionPixels;
+    ColorRemap::remapToPalette(video.getPixels(), sourceRegion,
+                               colorSwatches[colorIndex1], colorSwatches[colorIndex2], regionPixels);
+    return uploadRemapped(regionPixels);
+}
+
+void VideoElement::drawLabel(int index) const {
+    if(isPrimary()) {
+        // Draw primary indicator in red with asterisk
+        ofSetColor(255, 0, 0);  // Red color
+        ofDrawBitmapStringHighlight(ofToString(index) + " *", x + 5, y + 15, ofColor(255, 0, 0), ofColor(0));
+        ofSetColor(255);  // Reset color
+    } else {
+        // Draw normal index
+        ofDrawBitmapStringHighlight(ofToString(index), x + 5, y + 15);
     }
 }
 
@@ -1,7 +1,7 @@
 #pragma once
 #include "BaseElement.h"
-#include "ofxCv.h"
-#include "opencv2/opencv.hpp"
+#include "VideoSource.h"
+#include "TileRenderer.h"
 
 
 class VideoElement : public BaseElement {
@@ -9,8 +9,10 @@ public:
     VideoElement();
     virtual ~VideoElement() = default;
     void update();
-    void draw(const vector<ofVideoPlayer>& videos, const vector<ofColor>& colorSwatches, 
-             bool isEditMode, int index);
+    void draw(const vector<VideoSource>& videos, const vector<ofColor>& colorSwatches);
+    void addToBatch(TileRenderer& renderer, const vector<VideoSource>& videos, 
+                    const vector<ofColor>& colorSwatches);
+    void drawLabel(int index) const;
     void setVideoRegion(size_t index, const ofRectangle& region);
     
     size_t videoIndex;
@@ -19,4 +21,6 @@ public:
     static constexpr float POSITION_CHANGE_THRESHOLD = 0.01f;
     float lastPosition;
     
+private:
+    const ofTexture& remapOnCpu(const VideoSource& video, const vector<ofColor>& colorSwatches) const;
 }; 
\ No newline at end of file
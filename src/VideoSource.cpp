@@ -0,0 +1,244 @@
+#include "VideoSource.h"
+#include "ColorRemap.h"
+
+static const int SEEK_WAIT_ATTEMPTS = 1000;    // about 1 ms apart
+
+VideoSource::VideoSource() {
+}
+
+bool VideoSource::load(const string& path) {
+    close();
+    if(!loadPlayer(path)) {
+        return false;
+    }
+    // Regions are applied to the new ring on the next setTileRegions()
+    regionSet = RegionSet();
+    if(useLoopCache) {
+        openLoopCache();
+    }
+    return true;
+}
+
+bool VideoSource::loadPlayer(const string& path) {
+    if(lumaOnly) {
+        // Prefer the decoder's native planar layout, then plain gray
+        player.setUseTexture(false);
+        if(player.setPixelFormat(OF_PIXELS_NV12) || player.setPixelFormat(OF_PIXELS_GRAY)) {
+            if(player.load(path) && ColorRemap::isLumaFormat(player.getPixelFormat())) {
+                return true;
+            }
+            player.close();
+        }
+        ofLogWarning() << "No luma decoding for " << path << ", using RGB from now on";
+        lumaOnly = false;
+        lumaUnsupported = true;
+    }
+    player.setPixelFormat(OF_PIXELS_RGB);
+    
+    // Frames are uploaded through our own ring when pixel buffers are available
+    bool useRing = PixelBufferRing::isSupported();
+    player.setUseTexture(!useRing);
+    if(!player.load(path)) {
+        return false;
+    }
+    
+    if(useRing) {
+        ring = make_unique<PixelBufferRing>();
+        if(!ring->allocate(player.getWidth(), player.getHeight(), player.getPixelFormat())) {
+            // Reload with the player's own texture upload
+            ring.reset();
+            player.close();
+            player.setUseTexture(true);
+            return player.load(path);
+        }
+    }
+    return true;
+}
+
+void VideoSource::close() {
+    closeLoopCache();
+    ring.reset();
+    if(player.isLoaded()) {
+        player.close();
+    }
+}
+
+void VideoSource::update() {
+    if(loopCache && !cacheActive && loopCache->update()) {
+        // Cache is ready, take over from the decoder at the same point
+        cacheTime = getPosition();
+        cachePlaying = player.isPlaying() && !player.isPaused();
+        cacheFrame = -1;
+        cacheActive = true;
+        player.setPaused(true);
+    }
+    if(cacheActive) {
+        updateFromLoopCache();
+        return;
+    }
+    
+    player.update();
+    
+    if(ring && player.isFrameNew()) {
+        ring->write(player.getPixels(), ofGetElapsedTimeMicros());
+        ring->update();
+    }
+}
+
+bool VideoSource::setLumaOnly(bool enabled) {
+    if(enabled == lumaOnly || !player.isLoaded()) return lumaOnly;
+    if(enabled && lumaUnsupported) return false;
+    
+    // Reload in the other format, keeping the playhead
+    string path = player.getMoviePath();
+    float position = getPosition() / max(player.getDuration(), 0.001f);
+    bool playing = isPlaying();
+    lumaOnly = enabled;
+    if(!load(path)) {
+        ofLogError() << "Failed to reload " << path;
+        return lumaOnly;
+    }
+    player.setPosition(position);
+    if(playing) player.play();
+    return lumaOnly;
+}
+
+void VideoSource::setTileRegions(const vector<ofRectangle>& regions) {
+    if(!regionSet.update(getWidth(), getHeight(), regions) || !ring) return;
+    if(regionSet.isFullFrame()) {
+        ring->setFullFrame();
+    } else {
+        ring->setRegions(regionSet.getRects());
+    }
+}
+
+void VideoSource::play() {
+    if(cacheActive) {
+        cachePlaying = true;
+    } else {
+        player.play();
+    }
+}
+
+void VideoSource::setSpeed(float newSpeed) {
+    speed = newSpeed;
+    if(!cacheActive) {
+        player.setSpeed(newSpeed);
+    }
+}
+
+float VideoSource::getPosition() const {
+    return cacheActive ? cacheTime : player.getPosition() * player.getDuration();
+}
+
+void VideoSource::setUseLoopCache(bool use) {
+    if(use == useLoopCache) return;
+    useLoopCache = use;
+    if(use) {
+        openLoopCache();
+    } else {
+        closeLoopCache();
+    }
+}
+
+void VideoSource::openLoopCache() {
+    if(!player.isLoaded()) return;
+    loopCache = make_unique<LoopFrameCache>();
+    if(!loopCache->open(player)) {
+        // Too long or too large, keep decoding
+        loopCache.reset();
+    }
+}
+
+void VideoSource::closeLoopCache() {
+    if(cacheActive) {
+        // Hand the playhead back to the decoder
+        float duration = player.getDuration();
+        if(duration > 0) {
+            float time = fmod(cacheTime, duration);
+            player.setPosition((time < 0 ? time + duration : time) / duration);
+        }
+        player.setSpeed(speed);
+        player.setPaused(!cachePlaying);
+        cacheActive = false;
+        cachePixels = nullptr;
+    }
+    loopCache.reset();
+}
+
+void VideoSource::updateFromLoopCache() {
+    if(cachePlaying) {
+        cacheTime += ofGetLastFrameTime() * speed;
+    }
+    cacheTime = fmod(cacheTime, loopCache->getDuration());
+    if(cacheTime < 0) cacheTime += loopCache->getDuration();
+    int frame = loopCache->getFrameAt(cacheTime);
+    cacheFrameNew = frame != cacheFrame;
+    if(!cacheFrameNew) return;
+    
+    cacheFrame = frame;
+    cachePixels = &loopCache->getFrame(frame);
+    if(lumaOnly) return;
+    
+    if(ring) {
+        ring->write(*cachePixels, ofGetElapsedTimeMicros());
+        ring->update();
+    } else {
+        cacheTexture.loadData(*cachePixels);
+    }
+}
+
+bool VideoSource::seekTo(float seconds, bool waitForFrame) {
+    if(cacheActive) {
+        cacheTime = seconds;
+        return true;
+    }
+    
+    float duration = player.getDuration();
+    int totalFrames = player.getTotalNumFrames();
+    if(duration <= 0 || totalFrames <= 0) return false;
+    
+    float time = fmod(seconds, duration);
+    if(time < 0) time += duration;
+    int frame = min(int(time / duration * totalFrames), totalFrames - 1);
+    
+    player.setFrame(frame);
+    if(!waitForFrame) return true;
+    
+    // Some backends seek asynchronously, wait until the frame has landed
+    for(int attempt = 0; attempt < SEEK_WAIT_ATTEMPTS; attempt++) {
+        player.update();
+        if(player.getCurrentFrame() == frame) {
+            // update() won't see this frame as new any more
+            if(ring) {
+                ring->write(player.getPixels(), ofGetElapsedTimeMicros());
+                ring->update();
+            }
+            return true;
+        }
+        ofSleepMillis(1);
+    }
+    ofLogWarning() << ofFilePath::getFileName(player.getMoviePath()) << " did not reach frame " << frame;
+    return false;
+}
+
+const ofTexture& VideoSource::getTexture() const {
+    if(ring) return ring->getTexture();
+    return cacheActive ? cacheTexture : player.getTexture();
+}
+
+ResourceTracker::Usage VideoSource::getMemoryUsage() const {
+    ResourceTracker::Usage usage;
+    if(!player.isLoaded()) return usage;
+    
+    // Loop cache frames point into the mapping, they are counted there
+    usage.cpu = ResourceTracker::getBytes(player.getPixels());
+    usage.gpu = ResourceTracker::getBytes(player.getTexture()) + ResourceTracker::getBytes(cacheTexture);
+    if(ring) {
+        usage.gpu += ring->getBufferBytes() + ResourceTracker::getBytes(ring->getTexture());
+    }
+    if(loopCache) {
+        usage.mapped = loopCache->getMappedBytes();
+    }
+    return usage;
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include "ofMain.h"
+#include "PixelBufferRing.h"
+#include "LoopFrameCache.h"
+#include "RegionSet.h"
+#include "ResourceTracker.h"
+
+// A video player whose decoded frames reach the GPU through a ring of mapped
+// pixel buffers instead of a synchronous texture upload. Falls back to the
+// player's own texture when pixel buffer objects are not available.
+//
+// A source read only by CPU color remaps can decode to luma only: the player
+// hands over its Y plane with no conversion to RGB and nothing is uploaded.
+//
+// Short loops can play from a pre-decoded LoopFrameCache instead: once the
+// cache is built the player is paused and frames come from the mapped file.
+class VideoSource {
+public:
+    VideoSource();
+
+    bool load(const string& path);
+    void close();
+    void update();
+
+    // Playback control, forwarded to the player or the loop cache
+    void play();
+    void setSpeed(float speed);
+    // Shows the frame at a time into the video, wrapping around like a loop.
+    // Can wait for the decoder to show it, false if it never does.
+    bool seekTo(float seconds, bool waitForFrame = false);
+    bool isLoaded() const { return player.isLoaded(); }
+    bool isPlaying() const { return cacheActive ? cachePlaying : player.isPlaying(); }
+    bool isFrameNew() const { return cacheActive ? cacheFrameNew : player.isFrameNew(); }
+    int getCurrentFrame() const { return cacheActive ? cacheFrame : player.getCurrentFrame(); }
+    // Playhead in seconds, on the loop cache's clock while it plays
+    float getTime() const { return getPosition(); }
+    float getDuration() const { return player.getDuration(); }
+    string getMoviePath() const { return player.getMoviePath(); }
+    float getWidth() const { return player.getWidth(); }
+    float getHeight() const { return player.getHeight(); }
+
+    // Reloads the video decoding to the Y plane only, or back to RGB. Returns
+    // whether luma only is in effect, false if the player can't provide it.
+    bool setLumaOnly(bool lumaOnly);
+    bool isLumaOnly() const { return lumaOnly; }
+    // The decoder turned luma only down once, so it is never asked again
+    bool isLumaUnsupported() const { return lumaUnsupported; }
+
+    // Plays from a loop cache once it is built, for clips short enough to
+    // cache. Turning it off resumes the decoder where the cache left off.
+    void setUseLoopCache(bool use);
+    bool isUsingLoopCache() const { return cacheActive; }
+
+    // Limits frame copies and texture uploads to the areas these tile
+    // regions read; the rest of the texture goes stale
+    void setTileRegions(const vector<ofRectangle>& regions);
+    const RegionSet& getRegionSet() const { return regionSet; }
+
+    // RGB, or the Y plane first in a luma only source; no texture then
+    const ofPixels& getPixels() const { return cacheActive ? *cachePixels : player.getPixels(); }
+    const ofTexture& getTexture() const;
+    void draw(const ofRectangle& rect) const { getTexture().draw(rect); }
+
+    ofVideoPlayer& getPlayer() { return player; }
+    
+    // Decoded pixels, textures, upload buffers and the mapped loop cache
+    ResourceTracker::Usage getMemoryUsage() const;
+
+private:
+    bool loadPlayer(const string& path);
+    float getPosition() const;
+    void openLoopCache();
+    void closeLoopCache();
+    void updateFromLoopCache();
+
+    ofVideoPlayer player;
+    unique_ptr<PixelBufferRing> ring;
+    RegionSet regionSet;
+    bool lumaOnly = false;
+    bool lumaUnsupported = false;
+
+    // Loop cache playback, on its own clock while the player is paused
+    unique_ptr<LoopFrameCache> loopCache;
+    bool useLoopCache = false;
+    bool cacheActive = false;
+    bool cachePlaying = false;
+    bool cacheFrameNew = false;
+    float cacheTime = 0;
+    float speed = 1;
+    int cacheFrame = -1;
+    const ofPixels* cachePixels = nullptr;
+    ofTexture cacheTexture;    // without pixel buffers
+};
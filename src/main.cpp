@@ -2,12 +2,28 @@
 #include "ofApp.h"
 
 //========================================================================
-int main( ){
-	ofSetupOpenGL(1400,1050,OF_WINDOW);			// <-------- setup the GL context
+#ifndef TILE_BENCHMARK
+int main(int argc, char* argv[]){
+	OfflineRenderer::Settings launchSettings;
+	bool offline = OfflineRenderer::parseArguments(argc, argv, launchSettings);
+	
+	if(offline) {
+		// Offline renders draw into an FBO, the window only provides the GL context
+		ofGLFWWindowSettings settings;
+		settings.setSize(launchSettings.width, launchSettings.height);
+		settings.visible = false;
+		ofCreateWindow(settings);
+	} else {
+		ofSetupOpenGL(1400,1050,OF_WINDOW);			// <-------- setup the GL context
+	}
 
 	// this kicks off the running of my app
 	// can be OF_WINDOW or OF_FULLSCREEN
 	// pass in width and height too:
-	ofRunApp(new ofApp());
+	ofApp* app = new ofApp();
+	app->launchSettings = launchSettings;
+	// The exit status carries the --verify-remap result
+	return ofRunApp(app);
 
 }
+#endif
@@ -4,6 +4,7 @@
 //--------------------------------------------------------------
 void ofApp::setup(){
     ofSetFrameRate(60);
+    TraceRecorder::setThreadName("main");
     selectedTile = 0;
     adjustmentSpeed = 1.0;
     isDragging = false;
@@ -13,12 +14,78 @@ void ofApp::setup(){
     
     // Load the gradient texture
     VideoElement::loadGradientTexture();
+    ColorRemap::setup();
+    tileRenderer.setup();
+    
+    // Output windows share this window's context
+    mainWindow = ofGetCurrentWindow();
     
     setupGui();
     setupOsc();
-    loadLayout();
+    captureService.start();
+    
+    if(!launchSettings.layoutPath.empty()) {
+        setupOfflineRender();
+    } else {
+        loadLayout();
+        if(!launchSettings.recordOscPath.empty()) {
+            oscRecording.open(ofToDataPath(launchSettings.recordOscPath));
+            ofLog() << "Recording OSC input to " << launchSettings.recordOscPath;
+        }
+        playbackSync.setup(PlaybackSync::parseRole(launchSettings.syncRole), launchSettings.syncPort,
+                           launchSettings.syncTargets);
+    }
 
-    lastSwatchUpdate = ofGetElapsedTimef();
+    lastSwatchUpdate = getTime();
+}
+
+void ofApp::setupOfflineRender() {
+    // Every frame is rendered, as fast as possible, with the output only
+    showGui = false;
+    ofSetFrameRate(0);
+    ofSetVerticalSync(false);
+    ofSeedRandom(1);  // swatch clustering starts from random centroids
+    
+    loadLayoutFile(launchSettings.layoutPath);
+    
+    // The remap check plays sources normally and renders nothing out
+    if(launchSettings.verifyRemap) return;
+    
+    // Videos are stepped by the render clock instead of playing
+    for(auto& video : videos) {
+        video.getPlayer().setPaused(true);
+    }
+    videoTimes.assign(videos.size(), 0);
+    
+    if(!offline.setup(launchSettings)) {
+        ofExit(1);
+    }
+}
+
+float ofApp::getTime() const {
+    return offline.isActive() ? offline.getTime() : ofGetElapsedTimef();
+}
+
+float ofApp::getPlaybackSpeed(size_t videoIndex) const {
+    if(videoIndex >= videoPlaybackSettings.size()) return 1;
+    
+    const auto& settings = videoPlaybackSettings[videoIndex];
+    if(std::get<0>(settings) != APlaybackMode::OSC_PLAYBACK) return 1;
+    
+    // Get the appropriate OSC value based on input type
+    float value = 0;
+    switch(std::get<1>(settings)) {
+        case AOscInputType::YAW:
+            value = yawValue;
+            break;
+        case AOscInputType::PITCH:
+            value = pitchValue;
+            break;
+        case AOscInputType::ROLL:
+            value = rollValue;
+            break;
+    }
+    return ofMap(value, -1, 1, -10, 10, true);
 }
 
 void ofApp::setupGui() {
@@ -31,7 +98,18 @@ void ofApp::setupGui() {
     gui.add(loadLayoutBtn.setup("Load Selected Layout"));
     gui.add(addVideoBtn.setup("Add New Video"));
     gui.add(addImageBtn.setup("Add New Image"));
+    gui.add(newTileSize);
     gui.add(gradientToggle.setup("Show Gradient", true));
+    gui.add(gradientStrength);
+    gui.add(gpuRemapToggle.setup("GPU Color Remap", ColorRemap::isShaderAvailable()));
+    gui.add(dirtyRegionToggle.setup("Dirty Region Rendering", true));
+    gui.add(loopCacheToggle.setup("Loop Frame Cache", true));
+    gui.add(addOutputBtn.setup("Add Output"));
+    gui.add(memoryLabel.setup("Memory", ""));
+    gui.add(unusedSourcesLabel.setup("Unused Sources", ""));
+    gui.add(resourceStatsBtn.setup("Write Resource Stats"));
+    editOutput.set("Edit Output", 0, 0, 0);
+    gui.add(editOutput);
     
     // Add primary video selection
     gui.add(primaryVideoLabel.setup("Primary Video", ""));
@@ -52,6 +130,8 @@ void ofApp::setupGui() {
     infoPanel.add(changeVideoBtn.setup("Change Video"));
     infoPanel.add(tilePosLabel.setup("Position", ""));
     infoPanel.add(tileSizeLabel.setup("Source Region", ""));
+    infoPanel.add(cameraLatencyLabel.setup("Camera Latency", ""));
+    infoPanel.add(uploadRegionLabel.setup("Upload Region", ""));
     
     
     infoPanel.setPosition(gui.getPosition().x, gui.getPosition().y + gui.getHeight() + 100);
@@ -64,6 +144,13 @@ void ofApp::setupGui() {
     changeVideoBtn.addListener(this, &ofApp::changeSelectedVideo);
    
     gradientToggle.addListener(this, &ofApp::onGradientToggled);
+    gradientStrength.addListener(this, &ofApp::onGradientStrengthChanged);
+    gpuRemapToggle.addListener(this, &ofApp::onGpuRemapToggled);
+    dirtyRegionToggle.addListener(this, &ofApp::onDirtyRegionToggled);
+    loopCacheToggle.addListener(this, &ofApp::onLoopCacheToggled);
+    addOutputBtn.addListener(this, &ofApp::addOutput);
+    resourceStatsBtn.addListener(this, &ofApp::writeResourceStats);
+    editOutput.addListener(this, &ofApp::onEditOutputChanged);
     addImageBtn.addListener(this, &ofApp::loadNewImage);
     newLayoutBtn.addListener(this, &ofApp::createNewLayout);
     
@@ -85,12 +172,28 @@ void ofApp::setupGui() {
     color2Index.set("Color 2", 1, 0, NUM_SWATCHES-1);
     infoPanel.add(color1Index);
     infoPanel.add(color2Index);
+    tileOutput.set("Output", 0, 0, 0);
+    infoPanel.add(tileOutput);
+    infoPanel.add(tileSize);
     
     color1Index.addListener(this, &ofApp::onColor1Changed);
     color2Index.addListener(this, &ofApp::onColor2Changed);
+    tileOutput.addListener(this, &ofApp::onTileOutputChanged);
+    tileSize.addListener(this, &ofApp::onTileSizeChanged);
+    
+    // Camera device selection
+    gui.add(cameraDeviceLabel.setup("Camera", ""));
+    gui.add(cameraDevice);
+    gui.add(cameraWidth);
+    gui.add(cameraHeight);
+    gui.add(cameraFrameRate);
+    cameraDevice.addListener(this, &ofApp::onCameraDeviceChanged);
+    refreshCameraDevices();
     
     gui.add(addCameraBtn.setup("Add Camera Tile"));
     addCameraBtn.addListener(this, &ofApp::addCameraTile);
+    gui.add(addVirtualCameraBtn.setup("Add Virtual Camera"));
+    addVirtualCameraBtn.addListener(this, &ofApp::addVirtualCamera);
 
     // Setup video preview panel
     setupVideoPreviewPanel();
@@ -135,53 +238,83 @@ string ofApp::generateLayoutName() {
 
 //--------------------------------------------------------------
 void ofApp::update(){
-    updateOsc();
+    // A frame is this update() and the draw() after it
+    Profiler::frameDone();
+    PROFILE_SCOPE("update");
     
-    // Update all videos based on their playback settings
-    for(size_t i = 0; i < videos.size(); i++) {
-        auto& video = videos[i];
-        if(video.isLoaded()) {
-            if(i < videoPlaybackSettings.size()) {
-                const auto& settings = videoPlaybackSettings[i];
-                APlaybackMode mode = std::get<0>(settings);
-                
-                if(mode == APlaybackMode::LOOP) {
-                    // Normal looping behavior - ensure video is playing
-                    video.setSpeed(1);
-                    if(!video.isPlaying()) {
-                        video.play();
-                    }
-                } else if(mode == APlaybackMode::OSC_PLAYBACK) {
+    // Slider drags and held nudges are saved once they end. ofxGui keeps
+    // releases over its panels to itself, so this can't wait for mouseReleased.
+    if(!ofGetMousePressed() && !ofGetKeyPressed()) {
+        savePendingLayout();
+    }
+    
+    {
+        PROFILE_SCOPE("osc");
+        if(offline.isActive()) {
+            offline.replayOsc([this](const string& address, float value) { applyOscMessage(address, value); });
+        } else {
+            updateOsc();
+        }
+    }
+    
+    if(offline.isActive()) {
+        // Each video's playhead advances by its speed on the render clock
+        videoTimes.resize(videos.size(), 0);
+        for(size_t i = 0; i < videos.size(); i++) {
+            PROFILE_SCOPE("video update");
+            if(videos[i].isLoaded()) {
+                if(!videos[i].seekTo(videoTimes[i], true)) {
+                    // A stale frame would make the render differ from run to run
+                    ofLogError() << "Offline render failed at " << offline.getTime() << " s";
+                    renderFailed = true;
+                    ofExit(1);
+                    return;
+                }
+                videos[i].update();
+                videoTimes[i] += offline.getFrameDuration() * getPlaybackSpeed(i);
+            }
+        }
+    } else {
+        if(playbackSync.getRole() == PlaybackSync::FOLLOWER) {
+            PROFILE_SCOPE("sync");
+            playbackSync.receive();
+        }
+        
+        // Update all videos based on their playback settings
+        for(size_t i = 0; i < videos.size(); i++) {
+            PROFILE_SCOPE("video update");
+            auto& video = videos[i];
+            if(video.isLoaded()) {
+                if(i < videoPlaybackSettings.size()) {
+                    APlaybackMode mode = std::get<0>(videoPlaybackSettings[i]);
                     
-                    // OSC controlled playback - pause and seek based on OSC input
-                    // Make sure video is playing to allow frame updates
-                    if(!video.isPlaying()) {
-                        video.play();
-                    }
+                    // Short loops play from pre-decoded frames once cached
+                    video.setUseLoopCache(mode == APlaybackMode::LOOP && loopCacheEnabled);
                     
-                    // Get the appropriate OSC value based on input type
-                    AOscInputType oscType = std::get<1>(settings);
-                    float value = 0;
-                    switch(oscType) {
-                        case AOscInputType::YAW:
-                            value = yawValue;
-                            break;
-                        case AOscInputType::PITCH:
-                            value = pitchValue;
-                            break;
-                        case AOscInputType::ROLL:
-                            value = rollValue;
-                            break;
+                    if(mode == APlaybackMode::LOOP) {
+                        // Normal looping behavior - ensure video is playing.
+                        // Sync followers steer their rate toward the master's playhead.
+                        bool following = playbackSync.getRole() == PlaybackSync::FOLLOWER;
+                        video.setSpeed(following ? playbackSync.correct(video) : 1);
+                        if(!video.isPlaying()) {
+                            video.play();
+                        }
+                    } else if(mode == APlaybackMode::OSC_PLAYBACK) {
+                        // OSC controlled playback - speed follows the OSC input
+                        // Make sure video is playing to allow frame updates
+                        if(!video.isPlaying()) {
+                            video.play();
+                        }
+                        video.setSpeed(getPlaybackSpeed(i));
                     }
-                    
-                    float position = ofMap(value, -1, 1, -10, 10, true);
-                    // ofLog() << "Setting osc video position to: " << position * 100 << "%";
-                    // video.setPosition(position);
-                    video.setSpeed(position);
-                    // video.update();  // Force immediate frame update
                 }
+                video.update();
             }
-            video.update();
+        }
+        
+        if(playbackSync.getRole() == PlaybackSync::MASTER) {
+            PROFILE_SCOPE("sync");
+            playbackSync.send(videos);
         }
     }
     
@@ -200,7 +333,7 @@ void ofApp::update(){
 
     // Check if we need to update swatches periodically
     
-    float currentTime = ofGetElapsedTimef();
+    float currentTime = getTime();
     if(currentTime - lastSwatchUpdate > 5.0) {  // Every 10 seconds
         needsSwatchUpdate = true;
         lastSwatchUpdate = currentTime;
@@ -217,82 +350,194 @@ void ofApp::update(){
         tile.update();
     }
     
-    for(auto& camera : cameras) {
-        camera.update();
+    // Image regions drawn last frame are done with, keep the resident set capped
+    TiledImage::trim(images);
+    
+    // Memory accounting walks every source and tile, so only every few seconds
+    if((showGui || resources.isVisible()) &&
+       (lastResourceUpdate < 0 || ofGetElapsedTimef() - lastResourceUpdate > RESOURCE_UPDATE_INTERVAL)) {
+        updateResources();
+    }
+    
+    // Cameras only keep a CPU copy of their frames while a color-input tile reads it
+    vector<bool> cameraNeedsPixels(cameras.size(), false);
+    vector<bool> cameraNeedsColor(cameras.size(), false);
+    for(const auto& tile : cameraTiles) {
+        if(tile.cameraIndex >= cameras.size()) continue;
+        if(tile.hasColorInput() && !ColorRemap::isShaderEnabled()) {
+            cameraNeedsPixels[tile.cameraIndex] = true;
+        } else {
+            cameraNeedsColor[tile.cameraIndex] = true;
+        }
+    }
+    
+    // Sources read only by CPU remaps decode to luma, the primary video keeps
+    // color for the swatches. The mode follows the tiles' settings alone, so
+    // a source is only reloaded when those change, never on a GUI toggle;
+    // sources that turned luma down once stay in RGB.
+    if(!ColorRemap::isShaderEnabled()) {
+        vector<bool> videoNeedsLuma(videos.size(), false);
+        vector<bool> videoNeedsColor(videos.size(), false);
+        for(const auto& tile : tiles) {
+            if(tile.videoIndex >= videos.size()) continue;
+            if(tile.hasColorInput() && !tile.isPrimary()) {
+                videoNeedsLuma[tile.videoIndex] = true;
+            } else {
+                videoNeedsColor[tile.videoIndex] = true;
+            }
+        }
+        for(size_t i = 0; i < videos.size(); i++) {
+            videos[i].setLumaOnly(videoNeedsLuma[i] && !videoNeedsColor[i]);
+        }
+        for(size_t i = 0; i < cameras.size(); i++) {
+            cameras[i]->setLumaOnly(cameraNeedsPixels[i] && !cameraNeedsColor[i]);
+        }
+    } else {
+        for(auto& video : videos) video.setLumaOnly(false);
+        for(auto& camera : cameras) camera->setLumaOnly(false);
+    }
+    
+    // Sources only copy and upload the parts of the frame their tiles read
+    vector<vector<ofRectangle>> videoRegions(videos.size());
+    vector<vector<ofRectangle>> cameraRegions(cameras.size());
+    for(const auto& tile : tiles) {
+        if(tile.videoIndex < videos.size()) videoRegions[tile.videoIndex].push_back(tile.sourceRegion);
+    }
+    for(const auto& tile : cameraTiles) {
+        if(tile.cameraIndex < cameras.size()) cameraRegions[tile.cameraIndex].push_back(tile.sourceRegion);
+    }
+    for(size_t i = 0; i < videos.size(); i++) {
+        videos[i].setTileRegions(videoRegions[i]);
+    }
+    for(size_t i = 0; i < cameras.size(); i++) {
+        cameras[i]->setTileRegions(cameraRegions[i]);
+    }
+    
+    // Swap in the newest frame captured on the background thread
+    PROFILE_SCOPE("camera update");
+    for(size_t i = 0; i < cameras.size(); i++) {
+        // The remap check compares against the CPU copy, so it must stay current
+        cameras[i]->setKeepPixels(cameraNeedsPixels[i] || launchSettings.verifyRemap);
+        cameras[i]->update();
     }
 
 
 }
 
+//--------------------------------------------------------------
+void ofApp::exit(){
+    // Keep a recording that was still running
+    TraceRecorder::stop();
+    savePendingLayout();
+    offline.printStats();
+    captureService.stop();
+    captureService.clear();
+    cameras.clear();
+    outputs.clear();
+}
+
 //--------------------------------------------------------------
 void ofApp::draw(){
+    if(launchSettings.verifyRemap) {
+        // Sources get a few frames to decode and upload before the check
+        if(++remapCheckFrames == REMAP_CHECK_WARMUP_FRAMES) {
+            runRemapCheck();
+        }
+        return;
+    }
+    
+    if(!offline.isActive()) {
+        drawFrame();
+        return;
+    }
+    if(renderFailed) return;
+    
+    offline.begin();
+    drawFrame();
+    offline.end();
+    if(offline.isDone()) {
+        ofExit();
+    }
+}
+
+void ofApp::drawFrame(){
+    PROFILE_SCOPE("draw");
     ofBackground(0);
+    ColorRemap::updatePalette(colorSwatches);
     
-    // Draw video tiles
-    for(size_t i = 0; i < tiles.size(); i++) {
-        tiles[i].draw(videos, colorSwatches, showGui, i);
-        
-        // Show selection highlights in edit mode
-        if(showGui && ((isGroupSelected && find(selectedTiles.begin(), selectedTiles.end(), i) != selectedTiles.end()) ||
-           (!isGroupSelected && i == selectedTile))) {
-            ofPushStyle();
-            ofNoFill();
-            ofSetColor(255, 0, 0);
-            ofDrawRectangle(
-                tiles[i].x + tiles[i].offsetX, 
-                tiles[i].y + tiles[i].offsetY, 
-                VideoElement::TILE_SIZE, 
-                VideoElement::TILE_SIZE
-            );
-            ofFill();
-            ofPopStyle();
-        }
+    // Switching the output being edited shows a different set of tiles
+    int output = getMainOutput();
+    if(output != shownOutput) {
+        shownOutput = output;
+        staticLayer.invalidate();
     }
     
-    // Draw image tiles
-    for(size_t i = 0; i < imageTiles.size(); i++) {
-        imageTiles[i].draw(images, colorSwatches, showGui, i + tiles.size());  // Offset index for proper numbering
-        
-        // Show selection highlights in edit mode
-        if(showGui && ((isGroupSelected && find(selectedTiles.begin(), selectedTiles.end(), i + tiles.size()) != selectedTiles.end()) ||
-           (!isGroupSelected && i + tiles.size() == selectedTile))) {
-            ofPushStyle();
-            ofNoFill();
-            ofSetColor(255, 0, 0);
-            ofDrawRectangle(
-                imageTiles[i].x + imageTiles[i].offsetX, 
-                imageTiles[i].y + imageTiles[i].offsetY, 
-                ImageElement::TILE_SIZE, 
-                ImageElement::TILE_SIZE
-            );
-            ofFill();
-            ofPopStyle();
+    // Image tiles only change on edits, so they are rendered once into a cached layer
+    staticLayer.setPalette(colorSwatches);
+    if(!staticLayer.isValid()) {
+        renderStaticLayer(staticLayer, output);
+        changeTracker.invalidate();
+    }
+    
+    if(showGui || !dirtyRegionRendering) {
+        // The GUI can change anything, so edit mode always redraws everything
+        PROFILE_SCOPE("tiles");
+        changeTracker.invalidate();
+        drawTiles(output, staticLayer, ofRectangle(0, 0, ofGetWidth(), ofGetHeight()));
+    } else {
+        // Only redraw what changed since the last frame
+        PROFILE_SCOPE("tiles");
+        markChangedSources();
+        changeTracker.checkPalette(BaseElement::paletteGeneration);
+        if(changeTracker.hasChanges()) {
+            changeTracker.begin();
+            if(changeTracker.isFullRedraw()) {
+                ofClear(0, 0, 0, 255);
+                drawTiles(output, staticLayer, ofRectangle(0, 0, ofGetWidth(), ofGetHeight()));
+            } else {
+                for(const auto& rect : changeTracker.getDirtyRects()) {
+                    changeTracker.beginRegion(rect);
+                    ofClear(0, 0, 0, 255);
+                    drawTiles(output, staticLayer, rect);
+                    changeTracker.endRegion();
+                }
+            }
+            changeTracker.end();
         }
+        changeTracker.draw();
+        changeTracker.frameDone();
     }
     
-    // Draw camera tiles
-    for(size_t i = 0; i < cameraTiles.size(); i++) {
-        cameraTiles[i].draw(cameras, colorSwatches, showGui, i + tiles.size() + imageTiles.size());
+    if(showGui) {
+        // Labels for the tiles on screen, on top of all tiles
+        PROFILE_SCOPE("labels");
+        updateSpatialIndex();
+        spatialIndices[output].queryRect(ofRectangle(0, 0, ofGetWidth(), ofGetHeight()), visibleTiles);
+        size_t videoTilesEnd = tiles.size();
+        size_t imageTilesEnd = videoTilesEnd + imageTiles.size();
+        for(int index : visibleTiles) {
+            if(index < videoTilesEnd) {
+                tiles[index].drawLabel(index);
+            } else if(index < imageTilesEnd) {
+                imageTiles[index - videoTilesEnd].drawLabel(index);
+            } else {
+                cameraTiles[index - imageTilesEnd].drawLabel(index);
+            }
+        }
         
-        // Show selection highlights in edit mode
-        if(showGui && ((isGroupSelected && 
-            find(selectedTiles.begin(), selectedTiles.end(), i + tiles.size() + imageTiles.size()) != selectedTiles.end()) ||
-            (!isGroupSelected && i + tiles.size() + imageTiles.size() == selectedTile))) {
+        drawSelectionOutlines();
+    }
+    
+    if(showGui) {
+        PROFILE_SCOPE("gui");
+        if(isMarqueeSelecting) {
             ofPushStyle();
             ofNoFill();
             ofSetColor(255, 0, 0);
-            ofDrawRectangle(
-                cameraTiles[i].x + cameraTiles[i].offsetX,
-                cameraTiles[i].y + cameraTiles[i].offsetY,
-                CameraElement::TILE_SIZE,
-                CameraElement::TILE_SIZE
-            );
-            ofFill();
+            ofDrawRectangle(marqueeRect);
             ofPopStyle();
         }
-    }
-    
-    if(showGui) {
+        
         updateInfoPanel();
         updateVideoPreviewPanel();
         gui.draw();
@@ -303,6 +548,397 @@ void ofApp::draw(){
         }
         drawColorSwatches();
     }
+    
+    if(resources.isVisible()) {
+        // Lines are about 75 characters of 8px
+        resources.draw(ofGetWidth() - 620, 20);
+    }
+    
+    if(Profiler::isVisible()) {
+        Profiler::draw(20, ofGetHeight() - 20);
+        if(playbackSync.isActive()) {
+            playbackSync.draw(ofGetWidth() / 2, ofGetHeight() - 20);
+        }
+    }
+}
+
+void ofApp::renderStaticLayer(StaticLayerCache& layer, int output) {
+    PROFILE_SCOPE("static layer");
+    // Regions added since the last rebuild join the atlas, the rest keep their
+    // place. The atlas covers every output so outputs never repack each other.
+    vector<pair<size_t, ofRectangle>> atlasRegions;
+    for(const auto& tile : imageTiles) {
+        if(tile.isLoaded) atlasRegions.push_back(make_pair(tile.imageIndex, tile.sourceRegion));
+    }
+    imageAtlas.update(images, atlasRegions);
+    
+    // The output's image tiles, in draw order
+    vector<const ImageElement*> shown;
+    for(size_t i = 0; i < imageTiles.size(); i++) {
+        if(getTileOutput(tiles.size() + i) == output) shown.push_back(&imageTiles[i]);
+    }
+    
+    layer.begin();
+    if(tileRenderer.isAvailable()) {
+        for(const auto* tile : shown) {
+            if(!tile->isLoaded) tile->drawPlaceholder();
+        }
+        tileRenderer.begin();
+        for(const auto* tile : shown) {
+            tile->addToBatch(tileRenderer, images, imageAtlas, colorSwatches);
+        }
+        tileRenderer.end();
+    } else {
+        for(const auto* tile : shown) {
+            tile->draw(images, imageAtlas, colorSwatches);
+        }
+    }
+    layer.end();
+}
+
+void ofApp::invalidateStaticLayers() {
+    staticLayer.invalidate();
+    for(auto& window : outputs) {
+        window->staticLayer.invalidate();
+    }
+}
+
+int ofApp::getMainOutput() const {
+    // While editing the main window can show any output's tiles, otherwise its own
+    return showGui && editOutput.get() < getNumOutputs() ? editOutput.get() : 0;
+}
+
+void ofApp::openOutputs(const vector<OutputWindow::Settings>& settings) {
+    // Offline renders only draw the main output
+    if(!launchSettings.layoutPath.empty()) return;
+    
+    // Windows already open are moved rather than reopened, so switching
+    // layouts does not blank the projectors
+    while(outputs.size() > settings.size()) {
+        outputs.pop_back();
+    }
+    for(size_t i = 0; i < settings.size(); i++) {
+        if(i < outputs.size()) {
+            outputs[i]->apply(settings[i]);
+            continue;
+        }
+        auto window = make_unique<OutputWindow>();
+        int output = i + 1;
+        if(!window->open(mainWindow, settings[i], [this, output]() { drawOutput(output); })) break;
+        outputs.push_back(move(window));
+    }
+    ofLog() << "Outputs: main window and " << outputs.size() << " more";
+    spatialIndexDirty = true;
+    updateOutputSliders();
+}
+
+void ofApp::updateResources() {
+    PROFILE_SCOPE("resource accounting");
+    lastResourceUpdate = ofGetElapsedTimef();
+    resources.clear();
+    
+    // Tiles drawing each source; sources no tile draws are reported unused.
+    // changeSelectedVideo leaves the old player loaded for undo, for one.
+    vector<int> videoReferences(videos.size(), 0);
+    vector<int> imageReferences(images.size(), 0);
+    vector<int> cameraReferences(cameras.size(), 0);
+    vector<string> imageNames(images.size());
+    for(const auto& tile : tiles) {
+        if(tile.videoIndex < videos.size()) videoReferences[tile.videoIndex]++;
+    }
+    for(const auto& tile : imageTiles) {
+        if(tile.imageIndex >= images.size()) continue;
+        imageReferences[tile.imageIndex]++;
+        imageNames[tile.imageIndex] = ofFilePath::getFileName(tile.getPath());
+    }
+    for(const auto& tile : cameraTiles) {
+        if(tile.cameraIndex < cameras.size()) cameraReferences[tile.cameraIndex]++;
+    }
+    
+    for(size_t i = 0; i < videos.size(); i++) {
+        if(!videos[i].isLoaded()) continue;
+        resources.add(ResourceTracker::VIDEO, ofToString(i) + " " + ofFilePath::getFileName(videos[i].getMoviePath()),
+                      videos[i].getMemoryUsage(), videoReferences[i]);
+    }
+    for(size_t i = 0; i < images.size(); i++) {
+        if(!images[i].isAllocated()) continue;
+        resources.add(ResourceTracker::IMAGE, ofToString(i) + " " + imageNames[i], images[i].getMemoryUsage(), imageReferences[i]);
+    }
+    for(size_t i = 0; i < cameras.size(); i++) {
+        if(!cameras[i]) continue;
+        const auto& settings = cameras[i]->getSettings();
+        string name = settings.isVirtual() ? ofFilePath::getFileName(settings.videoPath)
+                                           : "device " + ofToString(settings.deviceId);
+        resources.add(ResourceTracker::CAMERA, ofToString(i) + " " + name, cameras[i]->getMemoryUsage(), cameraReferences[i]);
+    }
+    
+    for(size_t i = 0; i < tiles.size(); i++) {
+        resources.add(ResourceTracker::TILE, "video " + ofToString(i), tiles[i].getMemoryUsage());
+    }
+    for(size_t i = 0; i < imageTiles.size(); i++) {
+        resources.add(ResourceTracker::TILE, "image " + ofToString(tiles.size() + i), imageTiles[i].getMemoryUsage());
+    }
+    for(size_t i = 0; i < cameraTiles.size(); i++) {
+        resources.add(ResourceTracker::TILE, "camera " + ofToString(tiles.size() + imageTiles.size() + i),
+                      cameraTiles[i].getMemoryUsage());
+    }
+    
+    // Shared pools and scratch buffers
+    ResourceTracker::Usage usage;
+    usage.gpu = imageAtlas.getTextureBytes();
+    resources.add(ResourceTracker::POOL, "image atlas", usage);
+    
+    usage = ResourceTracker::Usage();
+    usage.gpu = staticLayer.getTextureBytes();
+    for(const auto& output : outputs) {
+        if(output) usage.gpu += output->staticLayer.getTextureBytes();
+    }
+    resources.add(ResourceTracker::POOL, "static layers", usage);
+    
+    usage = ResourceTracker::Usage();
+    usage.cpu = tileRenderer.getMeshBytes();
+    resources.add(ResourceTracker::POOL, "tile batches", usage);
+    
+    usage = ResourceTracker::Usage();
+    usage.cpu = ResourceTracker::getBytes(BaseElement::gradientPixels);
+    usage.gpu = ResourceTracker::getBytes(BaseElement::gradientTexture) + ResourceTracker::getBytes(ColorRemap::getPaletteTexture());
+    resources.add(ResourceTracker::POOL, "gradient and palette", usage);
+    
+    usage = ResourceTracker::Usage();
+    if(isCvImageAllocated) {
+        // The OpenCV image and its ofPixels copy
+        usage.cpu = uint64_t(cvImage.getWidth()) * cvImage.getHeight() * 3 * 2;
+    }
+    resources.add(ResourceTracker::POOL, "swatch scratch", usage);
+    
+    usage = ResourceTracker::Usage();
+    usage.cpu = history.getByteSize();
+    resources.add(ResourceTracker::POOL, "edit history", usage);
+    
+    ResourceTracker::Usage total = resources.getTotal();
+    memoryLabel = "CPU " + ResourceTracker::formatBytes(total.cpu) + ", GPU " + ResourceTracker::formatBytes(total.gpu) +
+                  ", mapped " + ResourceTracker::formatBytes(total.mapped);
+    unusedSourcesLabel = ofToString(resources.getNumUnreferenced());
+}
+
+void ofApp::writeResourceStats() {
+    updateResources();
+    
+    ofDirectory dir("stats");
+    if(!dir.exists()) {
+        dir.create();
+    }
+    string layoutName = selectedLayout >= 0 && selectedLayout < layoutFiles.size() ? layoutFiles[selectedLayout] : "unsaved";
+    resources.save(ofToDataPath("stats/resources-" + layoutName + "-" + ofGetTimestampString("%Y%m%d-%H%M%S") + ".json"),
+                   layoutName);
+}
+
+void ofApp::addOutput() {
+    // A new output opens beside the last window, at that window's size
+    vector<OutputWindow::Settings> settings;
+    for(const auto& window : outputs) {
+        settings.push_back(window->getSettings());
+    }
+    ofRectangle last = settings.empty()
+        ? ofRectangle(ofGetWindowPositionX(), ofGetWindowPositionY(), ofGetWidth(), ofGetHeight())
+        : settings.back().bounds;
+    OutputWindow::Settings added;
+    added.bounds.set(last.getRight(), last.y, last.width, last.height);
+    settings.push_back(added);
+    openOutputs(settings);
+    saveCurrentLayout();
+}
+
+void ofApp::drawOutput(int output) {
+    if(output < 1 || output > outputs.size()) return;
+    PROFILE_SCOPE("output draw");
+    OutputWindow& window = *outputs[output - 1];
+    
+    // Windows are drawn in no fixed order, so the palette may not be uploaded yet
+    ofBackground(0);
+    ColorRemap::updatePalette(colorSwatches);
+    window.staticLayer.setPalette(colorSwatches);
+    if(!window.staticLayer.isValid()) {
+        renderStaticLayer(window.staticLayer, output);
+    }
+    drawTiles(output, window.staticLayer, ofRectangle(0, 0, ofGetWidth(), ofGetHeight()));
+}
+
+void ofApp::updateOutputSliders() {
+    int last = getNumOutputs() - 1;
+    tileOutput.setMax(last);
+    editOutput.setMax(last);
+    if(editOutput > last) {
+        editOutput = 0;
+    }
+}
+
+void ofApp::drawTiles(int output, const StaticLayerCache& layer, const ofRectangle& clip) {
+    // Only the output's tiles intersecting the clip rectangle, in draw order
+    updateSpatialIndex();
+    spatialIndices[output].queryRect(clip, visibleTiles);
+    
+    size_t videoTilesEnd = tiles.size();
+    size_t imageTilesEnd = videoTilesEnd + imageTiles.size();
+    
+    if(tileRenderer.isAvailable()) {
+        // Dynamic tiles in one pass each, gradient and color remap included
+        tileRenderer.begin();
+        for(int index : visibleTiles) {
+            if(index >= videoTilesEnd) break;
+            tiles[index].addToBatch(tileRenderer, videos, colorSwatches);
+        }
+        tileRenderer.end();
+        
+        layer.draw();
+        
+        tileRenderer.begin();
+        for(int index : visibleTiles) {
+            if(index < imageTilesEnd) continue;
+            cameraTiles[index - imageTilesEnd].addToBatch(tileRenderer, cameras, colorSwatches);
+        }
+        tileRenderer.end();
+    } else {
+        for(int index : visibleTiles) {
+            if(index >= videoTilesEnd) break;
+            tiles[index].draw(videos, colorSwatches);
+        }
+        layer.draw();
+        for(int index : visibleTiles) {
+            if(index < imageTilesEnd) continue;
+            cameraTiles[index - imageTilesEnd].draw(cameras, colorSwatches);
+        }
+    }
+}
+
+void ofApp::drawSelectionOutlines() {
+    // All outlines go into one line mesh and a single draw call
+    selectionOutlines.clear();
+    selectionOutlines.setMode(OF_PRIMITIVE_LINES);
+    
+    auto addOutline = [&](int index) {
+        BaseElement* tile = getTile(index);
+        if(!tile) return;
+        TileQuad quad = tile->getTargetQuad();
+        for(int i = 0; i < 4; i++) {
+            selectionOutlines.addVertex(glm::vec3(quad[i], 0));
+            selectionOutlines.addVertex(glm::vec3(quad[(i + 1) % 4], 0));
+        }
+        // Cross on the corner w/a/s/d will move
+        if(activeCorner >= 0) {
+            const glm::vec2& corner = quad[activeCorner];
+            selectionOutlines.addVertex(glm::vec3(corner.x - 4, corner.y - 4, 0));
+            selectionOutlines.addVertex(glm::vec3(corner.x + 4, corner.y + 4, 0));
+            selectionOutlines.addVertex(glm::vec3(corner.x - 4, corner.y + 4, 0));
+            selectionOutlines.addVertex(glm::vec3(corner.x + 4, corner.y - 4, 0));
+        }
+    };
+    
+    size_t numTiles = tiles.size() + imageTiles.size() + cameraTiles.size();
+    if(isGroupSelected) {
+        for(int index : selectedTiles) {
+            if(index < numTiles) addOutline(index);
+        }
+    } else if(selectedTile >= 0 && selectedTile < numTiles) {
+        addOutline(selectedTile);
+    }
+    if(selectionOutlines.getNumVertices() == 0) return;
+    
+    ofPushStyle();
+    ofSetColor(255, 0, 0);
+    selectionOutlines.draw();
+    ofPopStyle();
+}
+
+ofRectangle ofApp::getTileRect(int index) const {
+    size_t videoTilesEnd = tiles.size();
+    size_t imageTilesEnd = videoTilesEnd + imageTiles.size();
+    
+    if(index < videoTilesEnd) {
+        return tiles[index].getBounds();
+    } else if(index < imageTilesEnd) {
+        return imageTiles[index - videoTilesEnd].getBounds();
+    }
+    return cameraTiles[index - imageTilesEnd].getBounds();
+}
+
+int ofApp::getTileOutput(int index) const {
+    size_t videoTilesEnd = tiles.size();
+    size_t imageTilesEnd = videoTilesEnd + imageTiles.size();
+    
+    int output = 0;
+    if(index < videoTilesEnd) {
+        output = tiles[index].getOutput();
+    } else if(index < imageTilesEnd) {
+        output = imageTiles[index - videoTilesEnd].getOutput();
+    } else if(index < imageTilesEnd + cameraTiles.size()) {
+        output = cameraTiles[index - imageTilesEnd].getOutput();
+    }
+    // Tiles of outputs the layout no longer opens fall back to the main window
+    return output >= 0 && output < getNumOutputs() ? output : 0;
+}
+
+void ofApp::updateSpatialIndex() {
+    size_t numTiles = tiles.size() + imageTiles.size() + cameraTiles.size();
+    size_t numIndexed = 0;
+    for(const auto& index : spatialIndices) {
+        numIndexed += index.size();
+    }
+    if(!spatialIndexDirty && spatialIndices.size() == getNumOutputs() && numIndexed == numTiles) return;
+    
+    // Global tile indices shift on deletes and loads, so those rebuild from scratch
+    spatialIndices.assign(getNumOutputs(), SpatialIndex());
+    for(size_t i = 0; i < numTiles; i++) {
+        spatialIndices[getTileOutput(i)].insert(i, getTileRect(i));
+    }
+    spatialIndexDirty = false;
+}
+
+void ofApp::updateTileBounds(int index) {
+    if(!spatialIndexDirty) {
+        spatialIndices[getTileOutput(index)].update(index, getTileRect(index));
+    }
+}
+
+void ofApp::markChangedSources() {
+    // One dirty rectangle per source that produced a new frame, covering its
+    // tiles on the main window's output
+    int output = getMainOutput();
+    vector<ofRectangle> videoRegions(videos.size());
+    vector<bool> videoChanged(videos.size(), false);
+    for(size_t i = 0; i < tiles.size(); i++) {
+        const auto& tile = tiles[i];
+        if(getTileOutput(i) != output) continue;
+        if(tile.videoIndex >= videos.size() || !videos[tile.videoIndex].isFrameNew()) continue;
+        if(videoChanged[tile.videoIndex]) {
+            videoRegions[tile.videoIndex].growToInclude(tile.getBounds());
+        } else {
+            videoRegions[tile.videoIndex] = tile.getBounds();
+            videoChanged[tile.videoIndex] = true;
+        }
+    }
+    
+    size_t imageTilesEnd = tiles.size() + imageTiles.size();
+    vector<ofRectangle> cameraRegions(cameras.size());
+    vector<bool> cameraChanged(cameras.size(), false);
+    for(size_t i = 0; i < cameraTiles.size(); i++) {
+        const auto& tile = cameraTiles[i];
+        if(getTileOutput(imageTilesEnd + i) != output) continue;
+        if(tile.cameraIndex >= cameras.size() || !cameras[tile.cameraIndex]->isFrameNew()) continue;
+        if(cameraChanged[tile.cameraIndex]) {
+            cameraRegions[tile.cameraIndex].growToInclude(tile.getBounds());
+        } else {
+            cameraRegions[tile.cameraIndex] = tile.getBounds();
+            cameraChanged[tile.cameraIndex] = true;
+        }
+    }
+    
+    for(size_t i = 0; i < videos.size(); i++) {
+        if(videoChanged[i]) changeTracker.addDirtyRect(videoRegions[i]);
+    }
+    for(size_t i = 0; i < cameras.size(); i++) {
+        if(cameraChanged[i]) changeTracker.addDirtyRect(cameraRegions[i]);
+    }
 }
 
 //--------------------------------------------------------------
@@ -377,25 +1013,49 @@ void ofApp::keyPressed(int key){
             }
             break;
             
-        // Adjust position
+        // Adjust position, or the active corner's warp
         case 'w': 
             dy = -adjustmentSpeed;
-            moveSelectedTiles(0, dy);
+            if(activeCorner >= 0) warpSelectedTiles(0, dy);
+            else moveSelectedTiles(0, dy);
             break;
             
         case 's':
             dy = adjustmentSpeed;
-            moveSelectedTiles(0, dy);
+            if(activeCorner >= 0) warpSelectedTiles(0, dy);
+            else moveSelectedTiles(0, dy);
             break;
             
         case 'a':
             dx = -adjustmentSpeed;
-            moveSelectedTiles(dx, 0);
+            if(activeCorner >= 0) warpSelectedTiles(dx, 0);
+            else moveSelectedTiles(dx, 0);
             break;
             
         case 'd':
             dx = adjustmentSpeed;
-            moveSelectedTiles(dx, 0);
+            if(activeCorner >= 0) warpSelectedTiles(dx, 0);
+            else moveSelectedTiles(dx, 0);
+            break;
+            
+        // Corner to warp, clockwise from the top-left; 0 moves whole tiles again
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+            activeCorner = key - '1';
+            break;
+            
+        case '0':
+            activeCorner = -1;
+            break;
+            
+        case 'r':  // Remove the warp from the selected tiles
+            resetSelectedWarps();
+            break;
+            
+        case 'e':  // Switch the selected tiles between bilinear and perspective warping
+            toggleSelectedPerspective();
             break;
             
         // Delete selected tile
@@ -404,22 +1064,46 @@ void ofApp::keyPressed(int key){
             break;
             
             
-        // Undo
+        // Undo, with shift to redo
         case 'z':
             if(ofGetKeyPressed(OF_KEY_COMMAND) || ofGetKeyPressed(OF_KEY_CONTROL)) {
                 undo();
             }
             break;
             
+        case 'Z':
+            if(ofGetKeyPressed(OF_KEY_COMMAND) || ofGetKeyPressed(OF_KEY_CONTROL)) {
+                redo();
+            }
+            break;
+            
         case 'c':  // Press 'c' to update color swatches
             if(isEditMode()) {
                 updateColorSwatchesFromPrimary();
             }
             break;
             
+        case 'p':  // Toggle the frame-time profiler
+            Profiler::toggle();
+            changeTracker.invalidate();
+            break;
+            
+        case 'm':  // Toggle the memory table
+            resources.toggle();
+            changeTracker.invalidate();
+            break;
+            
+        case 't':  // Start or stop a trace recording, written to data/traces/
+            TraceRecorder::toggle();
+            break;
+            
         case 'y':  // Add grid alignment
             alignTilesToGrid();
             break;
+            
+        case 'v':  // Compare the GPU color remap against the CPU kernel
+            verifySelectedTileRemap();
+            break;
     }
     
 
@@ -446,22 +1130,8 @@ void ofApp::mousePressed(int x, int y, int button) {
         
         // Alt+Shift+Click: Select all tiles
         if(ofGetKeyPressed(OF_KEY_ALT) && ofGetKeyPressed(OF_KEY_SHIFT)) {
-            selectedTiles.clear();
-            
-            // Add all video tiles
-            for(size_t i = 0; i < tiles.size(); i++) {
-                selectedTiles.push_back(i);
-            }
-            
-            // Add all image tiles
-            for(size_t i = 0; i < imageTiles.size(); i++) {
-                selectedTiles.push_back(i + tiles.size());
-            }
-            
-            // Add all camera tiles
-            for(size_t i = 0; i < cameraTiles.size(); i++) {
-                selectedTiles.push_back(i + tiles.size() + imageTiles.size());
-            }
+            // Video, image and camera tiles
+            selectedTiles.selectAll(tiles.size() + imageTiles.size() + cameraTiles.size());
             
             isGroupSelected = true;
             selectedTile = clickedTile;  // Keep track of clicked tile
@@ -472,10 +1142,8 @@ void ofApp::mousePressed(int x, int y, int button) {
         }
         // Alt+Click: Add/remove individual tile to/from selection
         else if(ofGetKeyPressed(OF_KEY_ALT)) {
-            auto it = find(selectedTiles.begin(), selectedTiles.end(), clickedTile);
-            if(it != selectedTiles.end()) {
-                // Remove from selection if already selected
-                selectedTiles.erase(it);
+            if(selectedTiles.remove(clickedTile)) {
+                // Removed from selection, it was already selected
                 if(selectedTiles.empty()) {
                     isGroupSelected = false;
                 }
@@ -484,18 +1152,18 @@ void ofApp::mousePressed(int x, int y, int button) {
                 if(!isGroupSelected) {
                     // If this is the first alt+click, add the currently selected tile first
                     if(selectedTile >= 0 && selectedTiles.empty()) {
-                        selectedTiles.push_back(selectedTile);
+                        selectedTiles.add(selectedTile);
                     }
                     isGroupSelected = true;
                 }
-                selectedTiles.push_back(clickedTile);
+                selectedTiles.add(clickedTile);
             }
             selectedTile = clickedTile;  // Update current tile
         } else {
             // Single tile selection
             selectedTile = clickedTile;
             selectedTiles.clear();
-            selectedTiles.push_back(clickedTile);
+            selectedTiles.add(clickedTile);
             isGroupSelected = false;
         }
         
@@ -525,11 +1193,20 @@ void ofApp::mousePressed(int x, int y, int button) {
             isGroupSelected = false;
         }
         isDragging = false;
+        
+        // Dragging from empty space draws a selection marquee
+        isMarqueeSelecting = true;
+        marqueeRect.set(x, y, 0, 0);
     }
 }
 
 //--------------------------------------------------------------
 void ofApp::mouseDragged(int x, int y, int button) {
+    if(isEditMode() && isMarqueeSelecting) {
+        marqueeRect.width = x - marqueeRect.x;
+        marqueeRect.height = y - marqueeRect.y;
+        return;
+    }
     if(!isEditMode() || !isDragging) return;
     
     float dx = x - dragStartPos.x;
@@ -550,25 +1227,54 @@ void ofApp::mouseDragged(int x, int y, int button) {
             int imageIndex = index - videoTilesEnd;
             imageTiles[imageIndex].x = startPos.x + dx;
             imageTiles[imageIndex].y = startPos.y + dy;
+            invalidateStaticLayers();
         } else {
             int cameraIndex = index - imageTilesEnd;
             cameraTiles[cameraIndex].x = startPos.x + dx;
             cameraTiles[cameraIndex].y = startPos.y + dy;
         }
+        updateTileBounds(index);
     }
 }
 
 //--------------------------------------------------------------
 void ofApp::mouseReleased(int x, int y, int button) {
-    if(isDragging) {
-        // Record the move for undo
-        vector<int> movedTiles = isGroupSelected ? selectedTiles : vector<int>{selectedTile};
-        recordTileMove(movedTiles, isGroupSelected);
-        
-        // Save the current layout
-        saveCurrentLayout();
+    if(isDragging && !selectedTiles.empty() && !tileRelativePositions.empty()) {
+        // Every selected tile moved by the same amount, record it once for undo
+        BaseElement* tile = getTile(selectedTiles[0]);
+        float dx = tile->x - tileRelativePositions[0].x;
+        float dy = tile->y - tileRelativePositions[0].y;
+        if(dx != 0 || dy != 0) {
+            history.push(make_unique<MoveTilesCommand>(selectedTiles.getIndices(), dx, dy));
+            
+            // Save the current layout
+            saveCurrentLayout();
+        }
     }
     isDragging = false;
+    
+    if(isMarqueeSelecting) {
+        isMarqueeSelecting = false;
+        selectTilesInRect(marqueeRect);
+    }
+}
+
+void ofApp::selectTilesInRect(const ofRectangle& rect) {
+    ofRectangle area = rect.getStandardized();
+    if(area.width < 2 && area.height < 2) return;  // a plain click, not a marquee
+    
+    updateSpatialIndex();
+    vector<int> found;
+    spatialIndices[getMainOutput()].queryRect(area, found);
+    if(found.empty()) return;
+    
+    // Alt keeps the existing selection and adds to it
+    if(!ofGetKeyPressed(OF_KEY_ALT)) selectedTiles.clear();
+    for(int index : found) {
+        selectedTiles.add(index);
+    }
+    selectedTile = found.back();
+    isGroupSelected = selectedTiles.size() > 1;
 }
 
 //--------------------------------------------------------------
@@ -597,10 +1303,11 @@ void ofApp::dragEvent(ofDragInfo dragInfo){
 }
 
 void ofApp::loadVideoAsTiles(const string& path) {
+    spatialIndexDirty = true;
     // Create new video player
     videos.emplace_back();
     size_t videoIndex = videos.size() - 1;
-    ofVideoPlayer& currentVideo = videos.back();
+    VideoSource& currentVideo = videos.back();
     
     // Load new video
     if(!currentVideo.load(path)) {
@@ -617,9 +1324,10 @@ void ofApp::loadVideoAsTiles(const string& path) {
     int videoWidth = currentVideo.getWidth();
     int videoHeight = currentVideo.getHeight();
     
-    // Calculate number of tiles needed
-    int tilesWide = ceil(float(videoWidth) / VideoElement::TILE_SIZE);
-    int tilesHigh = ceil(float(videoHeight) / VideoElement::TILE_SIZE);
+    // Calculate number of tiles needed at the chosen tile size
+    int sliceSize = newTileSize;
+    int tilesWide = ceil(float(videoWidth) / sliceSize);
+    int tilesHigh = ceil(float(videoHeight) / sliceSize);
     
     // Calculate starting position for this set of tiles
     float startX = 10;
@@ -631,16 +1339,17 @@ void ofApp::loadVideoAsTiles(const string& path) {
             VideoElement tile;
             
             // Position tile
-            float tileX = startX + x * VideoElement::TILE_SIZE;
-            float tileY = startY + y * VideoElement::TILE_SIZE;
+            float tileX = startX + x * sliceSize;
+            float tileY = startY + y * sliceSize;
             tile.setup(tileX, tileY);
+            tile.setTileSize(sliceSize);
             
             // Calculate source region for this tile
             ofRectangle region(
-                x * VideoElement::TILE_SIZE,
-                y * VideoElement::TILE_SIZE,
-                min(VideoElement::TILE_SIZE, videoWidth - x * VideoElement::TILE_SIZE),
-                min(VideoElement::TILE_SIZE, videoHeight - y * VideoElement::TILE_SIZE)
+                x * sliceSize,
+                y * sliceSize,
+                min(sliceSize, videoWidth - x * sliceSize),
+                min(sliceSize, videoHeight - y * sliceSize)
             );
             
             tile.setVideoRegion(videoIndex, region);
@@ -651,7 +1360,10 @@ void ofApp::loadVideoAsTiles(const string& path) {
 }
 
 void ofApp::deleteTile(int index) {
-    if(index >= 0) {
+    spatialIndexDirty = true;
+    if(getTile(index)) {
+        history.push(make_unique<DeleteTileCommand>(*this, index));
+        
         size_t videoTilesEnd = tiles.size();
         size_t imageTilesEnd = videoTilesEnd + imageTiles.size();
         size_t cameraTilesEnd = imageTilesEnd + cameraTiles.size();
@@ -663,6 +1375,7 @@ void ofApp::deleteTile(int index) {
             // Delete image tile
             int imageIndex = index - videoTilesEnd;
             imageTiles.erase(imageTiles.begin() + imageIndex);
+            invalidateStaticLayers();
         } else if(index < cameraTilesEnd) {
             // Delete camera tile
             int cameraIndex = index - imageTilesEnd;
@@ -674,60 +1387,21 @@ void ofApp::deleteTile(int index) {
             selectedTile = max(0, (int)(tiles.size() + imageTiles.size() + cameraTiles.size()) - 1);
         }
         
-        // Clear group selection if the deleted tile was part of it
-        if(isGroupSelected) {
-            auto it = find(selectedTiles.begin(), selectedTiles.end(), index);
-            if(it != selectedTiles.end()) {
-                selectedTiles.erase(it);
-                if(selectedTiles.empty()) {
-                    isGroupSelected = false;
-                }
-            }
+        // Drop the deleted tile from the selection, later tiles move down one index
+        selectedTiles.eraseIndex(index);
+        if(isGroupSelected && selectedTiles.empty()) {
+            isGroupSelected = false;
         }
         
         // Save the current layout after deletion
         saveCurrentLayout();
     }
-}
-
-int ofApp::findTileUnderMouse(int x, int y) {
-    // Check camera tiles first (they're drawn on top)
-    for(int i = cameraTiles.size() - 1; i >= 0; i--) {
-        const auto& tile = cameraTiles[i];
-        float tileX = tile.x + tile.offsetX;
-        float tileY = tile.y + tile.offsetY;
-        
-        if(x >= tileX && x < tileX + CameraElement::TILE_SIZE &&
-           y >= tileY && y < tileY + CameraElement::TILE_SIZE) {
-            return i + tiles.size() + imageTiles.size();  // Return offset index for camera tiles
-        }
-    }
-    
-    // Check image tiles
-    for(int i = imageTiles.size() - 1; i >= 0; i--) {
-        const auto& tile = imageTiles[i];
-        float tileX = tile.x + tile.offsetX;
-        float tileY = tile.y + tile.offsetY;
-        
-        if(x >= tileX && x < tileX + ImageElement::TILE_SIZE &&
-           y >= tileY && y < tileY + ImageElement::TILE_SIZE) {
-            return i + tiles.size();  // Return offset index for image tiles
-        }
-    }
-    
-    // Check video tiles
-    for(int i = tiles.size() - 1; i >= 0; i--) {
-        const auto& tile = tiles[i];
-        float tileX = tile.x + tile.offsetX;
-        float tileY = tile.y + tile.offsetY;
-        
-        if(x >= tileX && x < tileX + VideoElement::TILE_SIZE &&
-           y >= tileY && y < tileY + VideoElement::TILE_SIZE) {
-            return i;
-        }
-    }
-    
-    return -1;
+}
+
+int ofApp::findTileUnderMouse(int x, int y) {
+    // Camera tiles are drawn on top, then images, then videos, which is global index order
+    updateSpatialIndex();
+    return spatialIndices[getMainOutput()].queryPoint(x, y);
 }
 
 void ofApp::selectTilesFromSameSource(int tileIndex) {
@@ -742,7 +1416,7 @@ void ofApp::selectTilesFromSameSource(int tileIndex) {
         size_t videoIndex = tiles[tileIndex].videoIndex;
         for(int i = 0; i < tiles.size(); i++) {
             if(tiles[i].videoIndex == videoIndex) {
-                selectedTiles.push_back(i);
+                selectedTiles.add(i);
             }
         }
     } else if(tileIndex < imageTilesEnd) {
@@ -751,7 +1425,7 @@ void ofApp::selectTilesFromSameSource(int tileIndex) {
         size_t sourceImageIndex = imageTiles[imageIndex].imageIndex;
         for(int i = 0; i < imageTiles.size(); i++) {
             if(imageTiles[i].imageIndex == sourceImageIndex) {
-                selectedTiles.push_back(i + videoTilesEnd);
+                selectedTiles.add(i + videoTilesEnd);
             }
         }
     } else if(tileIndex < cameraTilesEnd) {
@@ -760,7 +1434,7 @@ void ofApp::selectTilesFromSameSource(int tileIndex) {
         size_t sourceCameraIndex = cameraTiles[cameraIndex].cameraIndex;
         for(int i = 0; i < cameraTiles.size(); i++) {
             if(cameraTiles[i].cameraIndex == sourceCameraIndex) {
-                selectedTiles.push_back(i + imageTilesEnd);
+                selectedTiles.add(i + imageTilesEnd);
             }
         }
     }
@@ -773,7 +1447,7 @@ void ofApp::moveSelectedTiles(float dx, float dy) {
     vector<int> movedTiles;
     
     if(isGroupSelected) {
-        movedTiles = selectedTiles;
+        movedTiles = selectedTiles.getIndices();
         for(int index : selectedTiles) {
             size_t videoTilesEnd = tiles.size();
             size_t imageTilesEnd = videoTilesEnd + imageTiles.size();
@@ -787,12 +1461,14 @@ void ofApp::moveSelectedTiles(float dx, float dy) {
                 int imageIndex = index - videoTilesEnd;
                 imageTiles[imageIndex].x += dx;
                 imageTiles[imageIndex].y += dy;
+                invalidateStaticLayers();
             } else {
                 // Move camera tile
                 int cameraIndex = index - imageTilesEnd;
                 cameraTiles[cameraIndex].x += dx;
                 cameraTiles[cameraIndex].y += dy;
             }
+            updateTileBounds(index);
         }
     } else if(selectedTile >= 0) {
         movedTiles = {selectedTile};
@@ -808,77 +1484,149 @@ void ofApp::moveSelectedTiles(float dx, float dy) {
             int imageIndex = selectedTile - videoTilesEnd;
             imageTiles[imageIndex].x += dx;
             imageTiles[imageIndex].y += dy;
+            invalidateStaticLayers();
         } else {
             // Move camera tile
             int cameraIndex = selectedTile - imageTilesEnd;
             cameraTiles[cameraIndex].x += dx;
             cameraTiles[cameraIndex].y += dy;
         }
+        updateTileBounds(selectedTile);
     }
     
-    // Record the move for undo if using keyboard
-    if(dx != 0 || dy != 0) {
-        recordTileMove(movedTiles, isGroupSelected);
+    // Record the move for undo, held-key repeats fold into one step
+    if(!movedTiles.empty() && (dx != 0 || dy != 0)) {
+        history.push(make_unique<MoveTilesCommand>(movedTiles, dx, dy), true);
     }
 }
 
-void ofApp::recordTileMove(const vector<int>& tileIndices, bool isGroup) {
-    MoveAction action;
-    action.isGroup = isGroup;
+BaseElement* ofApp::getTile(int index) {
+    if(index < 0) return nullptr;
+    size_t videoTilesEnd = tiles.size();
+    size_t imageTilesEnd = videoTilesEnd + imageTiles.size();
     
-    for(int index : tileIndices) {
-        if(index >= 0) {
-            TileMove move;
-            move.tileIndex = index;
-            
-            if(index < tiles.size()) {
-                // Record video tile position
-                move.newX = tiles[index].x;
-                move.newY = tiles[index].y;
-                move.oldX = tileStartPos.x - tiles[index].offsetX;
-                move.oldY = tileStartPos.y - tiles[index].offsetY;
-            } else {
-                // Record image tile position
-                int imageIndex = index - tiles.size();
-                if(imageIndex < imageTiles.size()) {
-                    move.newX = imageTiles[imageIndex].x;
-                    move.newY = imageTiles[imageIndex].y;
-                    move.oldX = tileStartPos.x - imageTiles[imageIndex].offsetX;
-                    move.oldY = tileStartPos.y - imageTiles[imageIndex].offsetY;
-                }
-            }
-            action.moves.push_back(move);
-        }
+    if(index < videoTilesEnd) {
+        return &tiles[index];
+    } else if(index < imageTilesEnd) {
+        return &imageTiles[index - videoTilesEnd];
+    } else if(index < imageTilesEnd + cameraTiles.size()) {
+        return &cameraTiles[index - imageTilesEnd];
     }
+    return nullptr;
+}
+
+void ofApp::offsetTile(int index, float dx, float dy) {
+    BaseElement* tile = getTile(index);
+    if(!tile) return;
     
-    if(!action.moves.empty()) {
-        undoHistory.push_front(action);
-        if(undoHistory.size() > MAX_UNDO_HISTORY) {
-            undoHistory.pop_back();
+    tile->x += dx;
+    tile->y += dy;
+    if(index >= tiles.size() && index < tiles.size() + imageTiles.size()) {
+        invalidateStaticLayers();
+    }
+    updateTileBounds(index);
+}
+
+void ofApp::onTilesEdited(bool structural, bool save) {
+    invalidateStaticLayers();
+    changeTracker.invalidate();
+    
+    if(structural) {
+        // Indices after the edit point shifted, so the selection no longer matches
+        spatialIndexDirty = true;
+        selectedTiles.clear();
+        isGroupSelected = false;
+        int numTiles = tiles.size() + imageTiles.size() + cameraTiles.size();
+        if(selectedTile >= numTiles) {
+            selectedTile = numTiles - 1;
         }
+        updatePrimaryVideoDropdown();
+    }
+    updateInfoPanel();
+    if(save) {
+        saveCurrentLayout();
+        layoutSavePending = false;
+    } else {
+        layoutSavePending = true;
     }
 }
 
+void ofApp::savePendingLayout() {
+    if(!layoutSavePending) return;
+    saveCurrentLayout();
+    layoutSavePending = false;
+}
+
 void ofApp::undo() {
-    if(undoHistory.empty()) return;
-    
-    MoveAction& action = undoHistory.front();
-    for(const auto& move : action.moves) {
-        if(move.tileIndex < tiles.size()) {
-            // Undo video tile move
-            tiles[move.tileIndex].x = move.oldX;
-            tiles[move.tileIndex].y = move.oldY;
-        } else {
-            // Undo image tile move
-            int imageIndex = move.tileIndex - tiles.size();
-            if(imageIndex < imageTiles.size()) {
-                imageTiles[imageIndex].x = move.oldX;
-                imageTiles[imageIndex].y = move.oldY;
-            }
-        }
+    EditCommand* command = history.undo(*this);
+    if(command) {
+        onTilesEdited(command->isStructural());
+        ofLog() << "Undo " << command->getName();
+    }
+}
+
+void ofApp::redo() {
+    EditCommand* command = history.redo(*this);
+    if(command) {
+        onTilesEdited(command->isStructural());
+        ofLog() << "Redo " << command->getName();
+    }
+}
+
+vector<int> ofApp::getEditedTiles() const {
+    if(isGroupSelected) return selectedTiles.getIndices();
+    if(selectedTile >= 0) return {selectedTile};
+    return {};
+}
+
+void ofApp::warpSelectedTiles(float dx, float dy) {
+    vector<int> indices = getEditedTiles();
+    vector<TileState> before = TilePropertiesCommand::capture(*this, indices);
+    for(int index : indices) {
+        BaseElement* tile = getTile(index);
+        if(!tile) continue;
+        tile->setCornerOffset(activeCorner, tile->getCornerOffset(activeCorner) + glm::vec2(dx, dy));
+        updateTileBounds(index);
+    }
+    // Held keys nudge in steps, folded into one undo step and one save
+    recordPropertyChange("warp", before, true);
+    onTilesEdited(false, false);
+}
+
+void ofApp::resetSelectedWarps() {
+    vector<int> indices = getEditedTiles();
+    vector<TileState> before = TilePropertiesCommand::capture(*this, indices);
+    for(int index : indices) {
+        BaseElement* tile = getTile(index);
+        if(!tile) continue;
+        tile->resetWarp();
+        updateTileBounds(index);
+    }
+    recordPropertyChange("reset warp", before);
+    onTilesEdited(false);
+}
+
+void ofApp::toggleSelectedPerspective() {
+    vector<int> indices = getEditedTiles();
+    vector<TileState> before = TilePropertiesCommand::capture(*this, indices);
+    for(int index : indices) {
+        BaseElement* tile = getTile(index);
+        if(tile) tile->setPerspectiveWarp(!tile->hasPerspectiveWarp());
+    }
+    recordPropertyChange("warp mapping", before);
+    onTilesEdited(false);
+}
+
+void ofApp::recordPropertyChange(const string& name, const vector<TileState>& before, bool canMerge) {
+    vector<int> indices;
+    indices.reserve(before.size());
+    for(const auto& state : before) {
+        indices.push_back(state.index);
+    }
+    auto command = make_unique<TilePropertiesCommand>(name, before, TilePropertiesCommand::capture(*this, indices));
+    if(!command->empty()) {
+        history.push(move(command), canMerge);
     }
-    
-    undoHistory.pop_front();
 }
 
 string ofApp::getLayoutPath(const string& name) {
@@ -915,42 +1663,37 @@ void ofApp::saveLayout() {
     for(const auto& tile : tiles) {
         ofJson tileData;
         tileData["videoIndex"] = tile.videoIndex;
-        tileData["x"] = tile.x;
-        tileData["y"] = tile.y;
-        tileData["offsetX"] = tile.offsetX;
-        tileData["offsetY"] = tile.offsetY;
-        tileData["sourceRegion"] = {
-            {"x", tile.sourceRegion.x},
-            {"y", tile.sourceRegion.y},
-            {"width", tile.sourceRegion.width},
-            {"height", tile.sourceRegion.height}
-        };
-        tileData["isPrimary"] = tile.isPrimary();
-        tileData["useColorInput"] = tile.hasColorInput();
-        tileData["colorIndex1"] = tile.getColorIndex1();
-        tileData["colorIndex2"] = tile.getColorIndex2();
+        tile.saveToJson(tileData);
         layout["tiles"].push_back(tileData);
     }
     
+    // Save the projector outputs
+    layout["outputs"] = nlohmann::json::array();
+    for(const auto& window : outputs) {
+        layout["outputs"].push_back(window->getSettings().toJson());
+    }
+    
+    // Save cameras, camera tiles refer to these by index
+    layout["cameras"] = nlohmann::json::array();
+    for(const auto& camera : cameras) {
+        const auto& settings = camera->getSettings();
+        ofJson cameraData;
+        cameraData["deviceId"] = settings.deviceId;
+        cameraData["width"] = settings.width;
+        cameraData["height"] = settings.height;
+        cameraData["frameRate"] = settings.frameRate;
+        if(settings.isVirtual()) {
+            cameraData["path"] = settings.videoPath;
+        }
+        layout["cameras"].push_back(cameraData);
+    }
+    
     // Save camera tiles
     layout["cameraTiles"] = nlohmann::json::array();
     for(const auto& tile : cameraTiles) {
         ofJson tileData;
         tileData["cameraIndex"] = tile.cameraIndex;
-        tileData["x"] = tile.x;
-        tileData["y"] = tile.y;
-        tileData["offsetX"] = tile.offsetX;
-        tileData["offsetY"] = tile.offsetY;
-        tileData["sourceRegion"] = {
-            {"x", tile.sourceRegion.x},
-            {"y", tile.sourceRegion.y},
-            {"width", tile.sourceRegion.width},
-            {"height", tile.sourceRegion.height}
-        };
-        tileData["isPrimary"] = tile.isPrimary();
-        tileData["useColorInput"] = tile.hasColorInput();
-        tileData["colorIndex1"] = tile.getColorIndex1();
-        tileData["colorIndex2"] = tile.getColorIndex2();
+        tile.saveToJson(tileData);
         layout["cameraTiles"].push_back(tileData);
     }
     
@@ -980,23 +1723,51 @@ void ofApp::saveLayout() {
 
 void ofApp::loadLayout() {
     if(layoutFiles.empty() || selectedLayout >= layoutFiles.size()) return;
-    
-    string path = getLayoutPath(layoutFiles[selectedLayout]);
+    loadLayoutFile(getLayoutPath(layoutFiles[selectedLayout]));
+}
+
+void ofApp::loadLayoutFile(const string& path) {
+    PROFILE_SCOPE("layout load");
+    spatialIndexDirty = true;
     ofJson layout = ofLoadJson(path);
     
     // Clear existing elements
     tiles.clear();
+    history.clear();
     imageTiles.clear();
+    invalidateStaticLayers();
+    changeTracker.invalidate();
     cameraTiles.clear();
     videos.clear();
     images.clear();
+    imageAtlas.clear();
     videoPlaybackSettings.clear();  // Clear existing playback settings
     
     // Load global settings
     if(layout.contains("settings")) {
         VideoElement::showGradient = layout["settings"]["showGradient"];
         gradientToggle = VideoElement::showGradient;
+        if(layout["settings"].contains("gradientStrength")) {
+            gradientStrength = layout["settings"]["gradientStrength"].get<float>();
+        }
+        if(layout["settings"].contains("dirtyRegionRendering")) {
+            dirtyRegionToggle = layout["settings"]["dirtyRegionRendering"].get<bool>();
+            dirtyRegionRendering = dirtyRegionToggle;
+        }
+        if(layout["settings"].contains("loopFrameCache")) {
+            loopCacheToggle = layout["settings"]["loopFrameCache"].get<bool>();
+            loopCacheEnabled = loopCacheToggle;
+        }
+    }
+    
+    // Projector outputs beyond the main window
+    vector<OutputWindow::Settings> outputSettings;
+    if(layout.contains("outputs")) {
+        for(const auto& outputData : layout["outputs"]) {
+            outputSettings.push_back(OutputWindow::Settings::fromJson(outputData));
+        }
     }
+    openOutputs(outputSettings);
     
     // Create a map of paths to indices for videos
     map<string, size_t> videoPathToIndex;
@@ -1048,19 +1819,7 @@ void ofApp::loadLayout() {
     if(layout.contains("videoTiles")) {
         for(const auto& tileData : layout["videoTiles"]) {
             VideoElement tile;
-            tile.x = tileData["x"];
-            tile.y = tileData["y"];
-            tile.offsetX = tileData["offsetX"];
-            tile.offsetY = tileData["offsetY"];
-            
-            ofRectangle region(
-                tileData["sourceRegion"]["x"],
-                tileData["sourceRegion"]["y"],
-                tileData["sourceRegion"]["width"],
-                tileData["sourceRegion"]["height"]
-            );
-            
-            tile.setup(tile.x, tile.y);
+            ofRectangle region = tile.loadFromJson(tileData);
             
             // Get the path and find its corresponding index
             string path = tileData["path"].get<string>();
@@ -1069,16 +1828,6 @@ void ofApp::loadLayout() {
                 tile.setVideoRegion(videoIndex, region);
                 tile.setPath(path);
                 
-                if(tileData.contains("isPrimary")) {
-                    tile.setPrimary(tileData["isPrimary"]);
-                }
-                if(tileData.contains("useColorInput")) {
-                    tile.setColorInput(tileData["useColorInput"]);
-                }
-                if(tileData.contains("colorIndex1") && tileData.contains("colorIndex2")) {
-                    tile.setColorIndices(tileData["colorIndex1"], tileData["colorIndex2"]);
-                }
-                
                 tiles.push_back(tile);
             } else {
                 ofLog() << "Warning: Could not find video for path: " << path;
@@ -1090,30 +1839,9 @@ void ofApp::loadLayout() {
     if(layout.contains("imageTiles")) {
         for(const auto& tileData : layout["imageTiles"]) {
             ImageElement tile;
-            tile.x = tileData["x"];
-            tile.y = tileData["y"];
-            tile.offsetX = tileData["offsetX"];
-            tile.offsetY = tileData["offsetY"];
-            
-            ofRectangle region(
-                tileData["sourceRegion"]["x"],
-                tileData["sourceRegion"]["y"],
-                tileData["sourceRegion"]["width"],
-                tileData["sourceRegion"]["height"]
-            );
-            
-            tile.setup(tile.x, tile.y);
+            ofRectangle region = tile.loadFromJson(tileData);
             tile.setImageRegion(tileData["imageIndex"], region);
             
-            if(tileData.contains("isPrimary")) {
-                tile.setPrimary(tileData["isPrimary"]);
-            }
-            if(tileData.contains("useColorInput")) {
-                tile.setColorInput(tileData["useColorInput"]);
-            }
-            if(tileData.contains("colorIndex1") && tileData.contains("colorIndex2")) {
-                tile.setColorIndices(tileData["colorIndex1"], tileData["colorIndex2"]);
-            }
             if(tileData.contains("path")) {
                 tile.setPath(tileData["path"]);
             }
@@ -1122,36 +1850,49 @@ void ofApp::loadLayout() {
         }
     }
     
+    // Load cameras, reusing any that are already open with the same settings
+    vector<shared_ptr<CameraCapture>> previousCameras = cameras;
+    cameras.clear();
+    if(layout.contains("cameras")) {
+        for(const auto& cameraData : layout["cameras"]) {
+            CameraCapture::Settings settings;
+            settings.deviceId = cameraData["deviceId"];
+            settings.width = cameraData["width"];
+            settings.height = cameraData["height"];
+            settings.frameRate = cameraData["frameRate"];
+            if(cameraData.contains("path")) {
+                settings.videoPath = cameraData["path"].get<string>();
+            }
+            
+            auto it = find_if(previousCameras.begin(), previousCameras.end(),
+                [&](const shared_ptr<CameraCapture>& camera) { return camera->getSettings() == settings; });
+            if(it != previousCameras.end()) {
+                cameras.push_back(*it);
+                previousCameras.erase(it);
+            } else {
+                // Keep a placeholder on failure so camera tile indices stay valid
+                auto camera = make_shared<CameraCapture>();
+                camera->setup(settings);
+                cameras.push_back(camera);
+                captureService.add(camera);
+            }
+        }
+    }
+    for(auto& camera : previousCameras) {
+        captureService.remove(camera);
+    }
+    
     // Load camera tiles
     if(layout.contains("cameraTiles")) {
-        setupCamera();  // Ensure camera is available
+        // Layouts saved before cameras were listed used the default camera
+        if(cameras.empty() && !layout["cameraTiles"].empty()) {
+            setupCamera();
+        }
         for(const auto& tileData : layout["cameraTiles"]) {
             CameraElement tile;
-            tile.x = tileData["x"];
-            tile.y = tileData["y"];
-            tile.offsetX = tileData["offsetX"];
-            tile.offsetY = tileData["offsetY"];
-            
-            ofRectangle region(
-                tileData["sourceRegion"]["x"],
-                tileData["sourceRegion"]["y"],
-                tileData["sourceRegion"]["width"],
-                tileData["sourceRegion"]["height"]
-            );
-            
-            tile.setup(tile.x, tile.y);
+            ofRectangle region = tile.loadFromJson(tileData);
             tile.setCameraRegion(tileData["cameraIndex"], region);
             
-            if(tileData.contains("isPrimary")) {
-                tile.setPrimary(tileData["isPrimary"]);
-            }
-            if(tileData.contains("useColorInput")) {
-                tile.setColorInput(tileData["useColorInput"]);
-            }
-            if(tileData.contains("colorIndex1") && tileData.contains("colorIndex2")) {
-                tile.setColorIndices(tileData["colorIndex1"], tileData["colorIndex2"]);
-            }
-            
             cameraTiles.push_back(tile);
         }
     }
@@ -1197,27 +1938,68 @@ void ofApp::updateInfoPanel() {
     if(tile) {
         // Update tile info
         tileIndexLabel = "Tile Index: " + ofToString(selectedTile);
-        tilePosLabel = "Position: " + ofToString(tile->x) + ", " + ofToString(tile->y);
+        string position = "Position: " + ofToString(tile->x) + ", " + ofToString(tile->y);
+        if(tile->isWarped()) {
+            position += tile->hasPerspectiveWarp() ? " (perspective warp)" : " (bilinear warp)";
+        }
+        tilePosLabel = position;
         tileSizeLabel = "Source Region: " + 
             ofToString(tile->sourceRegion.x) + ", " + 
             ofToString(tile->sourceRegion.y) + ", " + 
             ofToString(tile->sourceRegion.width) + ", " + 
             ofToString(tile->sourceRegion.height);
         
+        // Capture-to-display latency for camera tiles
+        if(selectedTile >= imageTilesEnd) {
+            size_t cameraIndex = cameraTiles[selectedTile - imageTilesEnd].cameraIndex;
+            if(cameraIndex < cameras.size()) {
+                cameraLatencyLabel = "Latency: " + 
+                    ofToString(cameras[cameraIndex]->getLatencyMillis(), 1) + " ms (avg " +
+                    ofToString(cameras[cameraIndex]->getAverageLatencyMillis(), 1) + " ms)";
+            }
+        } else {
+            cameraLatencyLabel = "";
+        }
+        
+        // How much of the tile's source frame is copied and uploaded
+        const RegionSet* regions = nullptr;
+        if(selectedTile < videoTilesEnd) {
+            if(tiles[selectedTile].videoIndex < videos.size()) {
+                regions = &videos[tiles[selectedTile].videoIndex].getRegionSet();
+            }
+        } else if(selectedTile >= imageTilesEnd) {
+            size_t cameraIndex = cameraTiles[selectedTile - imageTilesEnd].cameraIndex;
+            if(cameraIndex < cameras.size()) {
+                regions = &cameras[cameraIndex]->getRegionSet();
+            }
+        }
+        if(regions) {
+            uploadRegionLabel = "Upload: " + ofToString(regions->getRects().size()) + " rects, " +
+                ofToString(regions->getSavedFraction() * 100, 0) + "% saved";
+        } else {
+            uploadRegionLabel = "";
+        }
+        
         // Remove listeners before updating values
         colorInputToggle.removeListener(this, &ofApp::onColorInputToggled);
         color1Index.removeListener(this, &ofApp::onColor1Changed);
         color2Index.removeListener(this, &ofApp::onColor2Changed);
+        tileOutput.removeListener(this, &ofApp::onTileOutputChanged);
+        tileSize.removeListener(this, &ofApp::onTileSizeChanged);
         
         // Update color input controls to match the selected tile
         colorInputToggle = tile->hasColorInput();
         color1Index = tile->getColorIndex1();
         color2Index = tile->getColorIndex2();
+        tileOutput = getTileOutput(selectedTile);
+        tileSize = tile->getTileSize();
         
         // Re-add listeners after updating values
         colorInputToggle.addListener(this, &ofApp::onColorInputToggled);
         color1Index.addListener(this, &ofApp::onColor1Changed);
         color2Index.addListener(this, &ofApp::onColor2Changed);
+        tileOutput.addListener(this, &ofApp::onTileOutputChanged);
+        tileSize.addListener(this, &ofApp::onTileSizeChanged);
     }
 }
 
@@ -1241,6 +2023,9 @@ void ofApp::changeSelectedVideo() {
         videos.back().play();
         
         // Update all tiles that use the same video as the selected tile
+        vector<int> videoTiles(tiles.size());
+        iota(videoTiles.begin(), videoTiles.end(), 0);
+        vector<TileState> before = TilePropertiesCommand::capture(*this, videoTiles);
         size_t oldVideoIndex = tiles[selectedTile].videoIndex;
         for(auto& tile : tiles) {
             if(tile.videoIndex == oldVideoIndex) {
@@ -1248,6 +2033,7 @@ void ofApp::changeSelectedVideo() {
                 tile.setPath(path);  // Make sure to update the path
             }
         }
+        recordPropertyChange("change video", before);
         
         // Save changes to current layout
         saveCurrentLayout();
@@ -1255,6 +2041,10 @@ void ofApp::changeSelectedVideo() {
 }
 
 void ofApp::saveCurrentLayout() {
+    PROFILE_SCOPE("layout save");
+    // Offline renders never write back to the layout they render
+    if(offline.isActive()) return;
+    
     if(layoutFiles.empty() || selectedLayout >= layoutFiles.size()) return;
     
     string path = getLayoutPath(layoutFiles[selectedLayout]);
@@ -1262,7 +2052,10 @@ void ofApp::saveCurrentLayout() {
     
     // Save global settings
     layout["settings"] = {
-        {"showGradient", VideoElement::showGradient}
+        {"showGradient", VideoElement::showGradient},
+        {"gradientStrength", VideoElement::gradientStrength},
+        {"dirtyRegionRendering", dirtyRegionRendering},
+        {"loopFrameCache", loopCacheEnabled}
     };
     
     // Save video paths and playback settings
@@ -1301,20 +2094,7 @@ void ofApp::saveCurrentLayout() {
     for(const auto& tile : tiles) {
         ofJson tileData;
         tileData["videoIndex"] = tile.videoIndex;
-        tileData["x"] = tile.x;
-        tileData["y"] = tile.y;
-        tileData["offsetX"] = tile.offsetX;
-        tileData["offsetY"] = tile.offsetY;
-        tileData["sourceRegion"] = {
-            {"x", tile.sourceRegion.x},
-            {"y", tile.sourceRegion.y},
-            {"width", tile.sourceRegion.width},
-            {"height", tile.sourceRegion.height}
-        };
-        tileData["isPrimary"] = tile.isPrimary();
-        tileData["useColorInput"] = tile.hasColorInput();
-        tileData["colorIndex1"] = tile.getColorIndex1();
-        tileData["colorIndex2"] = tile.getColorIndex2();
+        tile.saveToJson(tileData);
         tileData["path"] = tile.getPath();  // Save the path with each tile
         layout["videoTiles"].push_back(tileData);
     }
@@ -1324,43 +2104,38 @@ void ofApp::saveCurrentLayout() {
     for(const auto& tile : imageTiles) {
         ofJson tileData;
         tileData["imageIndex"] = tile.imageIndex;
-        tileData["x"] = tile.x;
-        tileData["y"] = tile.y;
-        tileData["offsetX"] = tile.offsetX;
-        tileData["offsetY"] = tile.offsetY;
-        tileData["sourceRegion"] = {
-            {"x", tile.sourceRegion.x},
-            {"y", tile.sourceRegion.y},
-            {"width", tile.sourceRegion.width},
-            {"height", tile.sourceRegion.height}
-        };
-        tileData["isPrimary"] = tile.isPrimary();
-        tileData["useColorInput"] = tile.hasColorInput();
-        tileData["colorIndex1"] = tile.getColorIndex1();
-        tileData["colorIndex2"] = tile.getColorIndex2();
+        tile.saveToJson(tileData);
         tileData["path"] = tile.getPath();  // Save the path with each tile
         layout["imageTiles"].push_back(tileData);
     }
     
+    // Save the projector outputs
+    layout["outputs"] = nlohmann::json::array();
+    for(const auto& window : outputs) {
+        layout["outputs"].push_back(window->getSettings().toJson());
+    }
+    
+    // Save cameras, camera tiles refer to these by index
+    layout["cameras"] = nlohmann::json::array();
+    for(const auto& camera : cameras) {
+        const auto& settings = camera->getSettings();
+        ofJson cameraData;
+        cameraData["deviceId"] = settings.deviceId;
+        cameraData["width"] = settings.width;
+        cameraData["height"] = settings.height;
+        cameraData["frameRate"] = settings.frameRate;
+        if(settings.isVirtual()) {
+            cameraData["path"] = settings.videoPath;
+        }
+        layout["cameras"].push_back(cameraData);
+    }
+    
     // Save camera tiles
     layout["cameraTiles"] = nlohmann::json::array();
     for(const auto& tile : cameraTiles) {
         ofJson tileData;
         tileData["cameraIndex"] = tile.cameraIndex;
-        tileData["x"] = tile.x;
-        tileData["y"] = tile.y;
-        tileData["offsetX"] = tile.offsetX;
-        tileData["offsetY"] = tile.offsetY;
-        tileData["sourceRegion"] = {
-            {"x", tile.sourceRegion.x},
-            {"y", tile.sourceRegion.y},
-            {"width", tile.sourceRegion.width},
-            {"height", tile.sourceRegion.height}
-        };
-        tileData["isPrimary"] = tile.isPrimary();
-        tileData["useColorInput"] = tile.hasColorInput();
-        tileData["colorIndex1"] = tile.getColorIndex1();
-        tileData["colorIndex2"] = tile.getColorIndex2();
+        tile.saveToJson(tileData);
         layout["cameraTiles"].push_back(tileData);
     }
     
@@ -1372,27 +2147,40 @@ void ofApp::setupOsc() {
     oscReceiver.setup(OSC_PORT);
 }
 
+void ofApp::applyOscMessage(const string& address, float value) {
+    if(address == "/yaw") {
+        ofLog() << "OSC Yaw received: " << value;
+        yawValue = value;
+    }
+    else if(address == "/pitch") {
+        ofLog() << "OSC Pitch received: " << value;
+        pitchValue = value;
+    }
+    else if(address == "/roll") {
+        ofLog() << "OSC Roll received: " << value;
+        rollValue = value;
+    }
+}
+
 void ofApp::updateOsc() {
     while(oscReceiver.hasWaitingMessages()) {
         ofxOscMessage m;
         oscReceiver.getNextMessage(m);
         
-        float value = 0;
-        
-        if(m.getAddress() == "/yaw") {
-            value = m.getArgAsFloat(0);
-            ofLog() << "OSC Yaw received: " << value;
-            yawValue = value;
+        if(m.getAddress() == "/yaw" || m.getAddress() == "/pitch" || m.getAddress() == "/roll") {
+            float value = m.getArgAsFloat(0);
+            applyOscMessage(m.getAddress(), value);
+            
+            // Same format the offline renderer replays
+            if(oscRecording.is_open()) {
+                oscRecording << ofGetElapsedTimef() << " " << m.getAddress() << " " << value << "\n";
+            }
         }
-        else if(m.getAddress() == "/pitch") {
-            value = m.getArgAsFloat(0);
-            ofLog() << "OSC Pitch received: " << value;
-            pitchValue = value;
+        else if(m.getAddress() == "/trace/start") {
+            TraceRecorder::start();
         }
-        else if(m.getAddress() == "/roll") {
-            value = m.getArgAsFloat(0);
-            ofLog() << "OSC Roll received: " << value;
-            rollValue = value;
+        else if(m.getAddress() == "/trace/stop") {
+            TraceRecorder::stop();
         }
     }
 }
@@ -1414,14 +2202,16 @@ void ofApp::loadNewVideo() {
         }
         
         videos.back().play();
+        size_t firstTile = tiles.size();
         
         // Get video dimensions
         float videoWidth = videos.back().getWidth();
         float videoHeight = videos.back().getHeight();
         
-        // Calculate number of tiles needed to cover the video
-        int tilesX = ceil(videoWidth / VideoElement::TILE_SIZE);
-        int tilesY = ceil(videoHeight / VideoElement::TILE_SIZE);
+        // Calculate number of tiles needed to cover the video at the chosen tile size
+        int sliceSize = newTileSize;
+        int tilesX = ceil(videoWidth / sliceSize);
+        int tilesY = ceil(videoHeight / sliceSize);
         
         // Create tiles for the video
         for(int y = 0; y < tilesY; y++) {
@@ -1429,25 +2219,28 @@ void ofApp::loadNewVideo() {
                 VideoElement tile;
                 
                 // Calculate position for the tile
-                float posX = x * VideoElement::TILE_SIZE;
-                float posY = y * VideoElement::TILE_SIZE;
+                float posX = x * sliceSize;
+                float posY = y * sliceSize;
                 
                 // Calculate source region for this tile
                 ofRectangle region;
-                region.x = x * VideoElement::TILE_SIZE;
-                region.y = y * VideoElement::TILE_SIZE;
-                region.width = std::min(static_cast<float>(VideoElement::TILE_SIZE), 
+                region.x = x * sliceSize;
+                region.y = y * sliceSize;
+                region.width = std::min(static_cast<float>(sliceSize), 
                                       videoWidth - region.x);
-                region.height = std::min(static_cast<float>(VideoElement::TILE_SIZE), 
+                region.height = std::min(static_cast<float>(sliceSize), 
                                        videoHeight - region.y);
                 
                 tile.setup(posX, posY);
+                tile.setTileSize(sliceSize);
                 tile.setVideoRegion(newVideoIndex, region);
                 tile.setPath(path);  // Make sure to set the path
                 tiles.push_back(tile);
             }
         }
         
+        history.push(make_unique<AddTilesCommand>(TileKind::VIDEO, firstTile, tiles.size() - firstTile));
+        
         // Save the current layout
         saveCurrentLayout();
         
@@ -1455,8 +2248,170 @@ void ofApp::loadNewVideo() {
     }
 }
 
+void ofApp::onTileOutputChanged(int& output) {
+    if(!isEditMode() || selectedTile < 0) return;
+    
+    // Moves the whole selection, or the selected tile alone
+    vector<int> indices = selectedTiles.empty() ? vector<int>{selectedTile} : selectedTiles.getIndices();
+    vector<TileState> before = TilePropertiesCommand::capture(*this, indices);
+    for(int index : indices) {
+        BaseElement* tile = getTile(index);
+        if(tile) tile->setOutput(output);
+    }
+    // A slider drag is one undo step, saved once it ends
+    recordPropertyChange("output", before, true);
+    spatialIndexDirty = true;
+    onTilesEdited(false, false);
+}
+
+void ofApp::onTileSizeChanged(int& size) {
+    if(!isEditMode() || selectedTile < 0) return;
+    
+    // Resizes the whole selection, or the selected tile alone
+    vector<int> indices = selectedTiles.empty() ? vector<int>{selectedTile} : selectedTiles.getIndices();
+    vector<TileState> before = TilePropertiesCommand::capture(*this, indices);
+    for(int index : indices) {
+        BaseElement* tile = getTile(index);
+        if(!tile) continue;
+        tile->setTileSize(size);
+        updateTileBounds(index);
+    }
+    // A slider drag is one undo step, saved once it ends
+    recordPropertyChange("tile size", before, true);
+    onTilesEdited(false, false);
+}
+
+void ofApp::onEditOutputChanged(int& output) {
+    // The selection belongs to the tiles that were shown
+    selectedTiles.clear();
+    isGroupSelected = false;
+    changeTracker.invalidate();
+}
+
 void ofApp::onGradientToggled(bool& value) {
     VideoElement::showGradient = value;
+    invalidateStaticLayers();
+}
+
+void ofApp::onGradientStrengthChanged(float& value) {
+    VideoElement::gradientStrength = value;
+    invalidateStaticLayers();
+}
+
+void ofApp::onGpuRemapToggled(bool& value) {
+    if(value && !ColorRemap::isShaderAvailable()) {
+        ofLog() << "GPU color remap is not available on this renderer";
+    }
+    ColorRemap::setShaderEnabled(value);
+    invalidateStaticLayers();
+}
+
+void ofApp::onDirtyRegionToggled(bool& value) {
+    dirtyRegionRendering = value;
+    changeTracker.invalidate();
+}
+
+void ofApp::onLoopCacheToggled(bool& value) {
+    // Sources switch over in the next update
+    loopCacheEnabled = value;
+}
+
+void ofApp::verifySelectedTileRemap() {
+    if(selectedTile < 0) return;
+    
+    // A camera's CPU copy is only current while a CPU remap reads it
+    int cameraTile = selectedTile - int(tiles.size() + imageTiles.size());
+    if(cameraTile >= 0 && cameraTile < cameraTiles.size()) {
+        size_t cameraIndex = cameraTiles[cameraTile].cameraIndex;
+        if(cameraIndex < cameras.size() && !cameras[cameraIndex]->hasCurrentPixels()) {
+            ofLog() << "Color remap check skipped for tile " << selectedTile << " (camera pixels are not kept)";
+            return;
+        }
+    }
+    
+    int difference = compareTileRemap(selectedTile, colorSwatches);
+    if(difference < 0) {
+        ofLog() << "Color remap check skipped for tile " << selectedTile << " (shader or pixels unavailable)";
+    } else {
+        ofLog() << "Color remap check for tile " << selectedTile << ": max channel difference " << difference;
+    }
+}
+
+int ofApp::compareTileRemap(int index, const vector<ofColor>& colors) {
+    size_t videoTilesEnd = tiles.size();
+    size_t imageTilesEnd = videoTilesEnd + imageTiles.size();
+    size_t cameraTilesEnd = imageTilesEnd + cameraTiles.size();
+    
+    if(index < videoTilesEnd) {
+        const auto& tile = tiles[index];
+        if(tile.videoIndex < videos.size()) {
+            const auto& video = videos[tile.videoIndex];
+            return ColorRemap::compareWithReference(video.getTexture(), video.getPixels(), tile.sourceRegion,
+                colors, tile.getColorIndex1(), tile.getColorIndex2());
+        }
+    } else if(index < imageTilesEnd) {
+        const auto& tile = imageTiles[index - videoTilesEnd];
+        if(tile.imageIndex < images.size()) {
+            auto& image = images[tile.imageIndex];
+            ofPixels regionPixels;
+            image.getRegionPixels(tile.sourceRegion, regionPixels);
+            return ColorRemap::compareWithReference(image.getRegionTexture(tile.sourceRegion), regionPixels,
+                ofRectangle(0, 0, regionPixels.getWidth(), regionPixels.getHeight()),
+                colors, tile.getColorIndex1(), tile.getColorIndex2());
+        }
+    } else if(index < cameraTilesEnd) {
+        const auto& tile = cameraTiles[index - imageTilesEnd];
+        if(tile.cameraIndex < cameras.size()) {
+            const auto& camera = cameras[tile.cameraIndex];
+            return ColorRemap::compareWithReference(camera->getTexture(), camera->getPixels(), tile.sourceRegion,
+                colors, tile.getColorIndex1(), tile.getColorIndex2());
+        }
+    }
+    return -1;
+}
+
+void ofApp::runRemapCheck() {
+    updateColorSwatchesFromPrimary();
+    // Distinct fixed endpoints as well, so a dark or uniform layout palette can't hide a mismatch
+    vector<ofColor> testPalette = {ofColor(255, 0, 0), ofColor(0, 255, 255), ofColor(0, 0, 255),
+                                   ofColor(255, 255, 0), ofColor(0), ofColor(255)};
+    testPalette.resize(colorSwatches.size(), ofColor(128));
+    
+    int numTiles = tiles.size() + imageTiles.size() + cameraTiles.size();
+    int compared = 0;
+    int skipped = 0;
+    int failed = 0;
+    int worst = 0;
+    for(int index = 0; index < numTiles; index++) {
+        BaseElement* tile = getTile(index);
+        if(!tile || !tile->hasColorInput()) continue;
+        
+        for(const auto* colors : {&colorSwatches, &testPalette}) {
+            int difference = compareTileRemap(index, *colors);
+            if(difference < 0) {
+                skipped++;
+                continue;
+            }
+            compared++;
+            worst = max(worst, difference);
+            if(difference > launchSettings.remapTolerance) {
+                failed++;
+                ofLogError() << "Color remap mismatch on tile " << index << ": max channel difference " << difference;
+            }
+        }
+    }
+    
+    int status = 0;
+    if(!ColorRemap::isShaderAvailable() || compared == 0) {
+        ofLogError() << "Color remap check could not compare any tile (shader "
+                     << (ColorRemap::isShaderAvailable() ? "available" : "unavailable") << ", " << skipped << " skipped)";
+        status = 2;
+    } else if(failed > 0) {
+        status = 1;
+    }
+    ofLog() << "Color remap check: " << compared << " compared, " << failed << " over tolerance "
+            << launchSettings.remapTolerance << ", " << skipped << " skipped, max difference " << worst;
+    ofExit(status);
 }
 
 void ofApp::updatePrimaryVideoDropdown() {
@@ -1485,6 +2440,10 @@ void ofApp::updatePrimaryVideoDropdown() {
 }
 
 void ofApp::onPrimaryVideoChanged(int& index) {
+    vector<int> videoTiles(tiles.size());
+    iota(videoTiles.begin(), videoTiles.end(), 0);
+    vector<TileState> before = TilePropertiesCommand::capture(*this, videoTiles);
+    
     // Clear existing primary status
     for(auto& tile : tiles) {
         tile.setPrimary(false);
@@ -1499,6 +2458,7 @@ void ofApp::onPrimaryVideoChanged(int& index) {
         }
     }
     
+    recordPropertyChange("primary", before);
     updatePrimaryVideoDropdown();
     needsSwatchUpdate = true;  // Request swatch update when primary changes
     saveCurrentLayout();
@@ -1517,6 +2477,7 @@ vector<string> ofApp::getUniqueVideoPaths() const {
 }
 
 void ofApp::updateColorSwatchesFromPrimary() {
+    PROFILE_SCOPE("swatches");
     // Find primary video
     int primaryVideoIndex = -1;
     for(const auto& tile : tiles) {
@@ -1549,66 +2510,13 @@ void ofApp::updateColorSwatchesFromPrimary() {
         cvImage.resize(PROCESS_WIDTH, processHeight);
         ofPixels smallPixels = cvImage.getPixels();
         
-        // Extract colors as HSV
-        vector<ofVec3f> colors;
-        for(int y = 0; y < processHeight; y++) {
-            for(int x = 0; x < PROCESS_WIDTH; x++) {
-                ofColor c = smallPixels.getColor(x, y);
-                float hue, sat, val;
-                c.getHsb(hue, sat, val);
-                colors.push_back(ofVec3f(hue, sat, val));
-            }
-        }
-        
-        // K-means clustering
-        vector<ofVec3f> centroids = colors;
-        random_shuffle(centroids.begin(), centroids.end());
-        centroids.resize(NUM_SWATCHES);
-        
-        vector<vector<ofVec3f>> clusters(NUM_SWATCHES);
-        for(const auto& color : colors) {
-            float minDist = FLT_MAX;
-            int closestCentroid = 0;
-            
-            for(int i = 0; i < NUM_SWATCHES; i++) {
-                float dist = (color - centroids[i]).length();
-                if(dist < minDist) {
-                    minDist = dist;
-                    closestCentroid = i;
-                }
-            }
-            
-            clusters[closestCentroid].push_back(color);
-        }
-        
-        // Calculate new colors
-        vector<ofColor> newColors(NUM_SWATCHES);
-        for(int i = 0; i < NUM_SWATCHES; i++) {
-            if(!clusters[i].empty()) {
-                ofVec3f sum(0, 0, 0);
-                for(const auto& color : clusters[i]) {
-                    sum += color;
-                }
-                ofVec3f centroid = sum / clusters[i].size();
-                
-                newColors[i].setHsb(
-                    centroid.x,
-                    centroid.y,
-                    centroid.z
-                );
-            }
-        }
-        
-        // Sort colors by brightness (value component)
-        sort(newColors.begin(), newColors.end(), [](const ofColor& a, const ofColor& b) {
-            float ha, sa, va, hb, sb, vb;
-            a.getHsb(ha, sa, va);
-            b.getHsb(hb, sb, vb);
-            return va > vb; // Sort descending (brightest first)
-        });
+        vector<ofColor> newColors = SwatchExtractor::extract(smallPixels, NUM_SWATCHES);
         
         // Update color swatches with sorted colors
-        colorSwatches = newColors;
+        if(newColors != colorSwatches) {
+            colorSwatches = newColors;
+            BaseElement::paletteGeneration++;
+        }
     }
 }
 
@@ -1679,7 +2587,10 @@ void ofApp::onColorInputToggled(bool& value) {
     
     if(tile) {
         // Set color input for this specific tile
+        vector<TileState> before = TilePropertiesCommand::capture(*this, {selectedTile});
         tile->setColorInput(value);
+        recordPropertyChange("color input", before);
+        invalidateStaticLayers();
         
         // Update the toggle to reflect the current state
         colorInputToggle = value;
@@ -1707,7 +2618,10 @@ void ofApp::onColor1Changed(int& index) {
     
     if(tile) {
         // Set color index for this specific tile
+        vector<TileState> before = TilePropertiesCommand::capture(*this, {selectedTile});
         tile->setColorIndices(index, tile->getColorIndex2());
+        recordPropertyChange("color 1", before);
+        invalidateStaticLayers();
         saveCurrentLayout();
     }
 }
@@ -1730,12 +2644,16 @@ void ofApp::onColor2Changed(int& index) {
     
     if(tile) {
         // Set color index for this specific tile
+        vector<TileState> before = TilePropertiesCommand::capture(*this, {selectedTile});
         tile->setColorIndices(tile->getColorIndex1(), index);
+        recordPropertyChange("color 2", before);
+        invalidateStaticLayers();
         saveCurrentLayout();
     }
 }
 
 void ofApp::loadNewImage() {
+    spatialIndexDirty = true;
     ofFileDialogResult result = ofSystemLoadDialog("Select Image File", false, "images/");
     if(result.bSuccess) {
         string path = result.getPath();
@@ -1750,13 +2668,16 @@ void ofApp::loadNewImage() {
             return;
         }
         
+        size_t firstTile = imageTiles.size();
+        
         // Get image dimensions
         float imageWidth = images.back().getWidth();
         float imageHeight = images.back().getHeight();
         
-        // Calculate number of tiles needed to cover the image
-        int tilesX = ceil(imageWidth / ImageElement::TILE_SIZE);
-        int tilesY = ceil(imageHeight / ImageElement::TILE_SIZE);
+        // Calculate number of tiles needed to cover the image at the chosen tile size
+        int sliceSize = newTileSize;
+        int tilesX = ceil(imageWidth / sliceSize);
+        int tilesY = ceil(imageHeight / sliceSize);
         
         // Create tiles for the image
         for(int y = 0; y < tilesY; y++) {
@@ -1764,24 +2685,28 @@ void ofApp::loadNewImage() {
                 ImageElement tile;
                 
                 // Calculate position for the tile
-                float posX = x * ImageElement::TILE_SIZE;
-                float posY = y * ImageElement::TILE_SIZE;
+                float posX = x * sliceSize;
+                float posY = y * sliceSize;
                 
                 // Calculate source region for this tile
                 ofRectangle region;
-                region.x = x * ImageElement::TILE_SIZE;
-                region.y = y * ImageElement::TILE_SIZE;
-                region.width = std::min(static_cast<float>(ImageElement::TILE_SIZE), 
+                region.x = x * sliceSize;
+                region.y = y * sliceSize;
+                region.width = std::min(static_cast<float>(sliceSize), 
                                       imageWidth - region.x);
-                region.height = std::min(static_cast<float>(ImageElement::TILE_SIZE), 
+                region.height = std::min(static_cast<float>(sliceSize), 
                                        imageHeight - region.y);
                 
                 tile.setup(posX, posY);
+                tile.setTileSize(sliceSize);
                 tile.setImageRegion(newImageIndex, region);
                 tile.setPath(path);  // Store the path for later use
                 imageTiles.push_back(tile);
             }
         }
+        invalidateStaticLayers();
+        
+        history.push(make_unique<AddTilesCommand>(TileKind::IMAGE, firstTile, imageTiles.size() - firstTile));
         
         // Save the current layout
         saveCurrentLayout();
@@ -1793,59 +2718,135 @@ void ofApp::loadNewImage() {
 void ofApp::setupCamera() {
     // Setup default camera if none exists
     if(cameras.empty()) {
-        cameras.emplace_back();
-        cameras.back().setup(640, 480);
+        CameraCapture::Settings settings;
+        settings.width = 512;
+        settings.height = 512;
+        openCamera(settings);
+    }
+}
+
+void ofApp::refreshCameraDevices() {
+    cameraDevices = CameraCapture::listDevices();
+    for(const auto& device : cameraDevices) {
+        ofLog() << "Camera " << device.id << ": " << device.deviceName;
+    }
+    
+    cameraDevice.setMax(max(0, (int)cameraDevices.size() - 1));
+    int index = cameraDevice;
+    onCameraDeviceChanged(index);
+}
+
+void ofApp::onCameraDeviceChanged(int& index) {
+    if(index >= 0 && index < cameraDevices.size()) {
+        cameraDeviceLabel = cameraDevices[index].deviceName;
+    } else {
+        cameraDeviceLabel = "No cameras found";
+    }
+}
+
+int ofApp::openCamera(const CameraCapture::Settings& settings) {
+    // A device or file can only be opened once, so share it between tile sets
+    for(size_t i = 0; i < cameras.size(); i++) {
+        const auto& existing = cameras[i]->getSettings();
+        bool sameSource = settings.isVirtual() ? existing.videoPath == settings.videoPath
+                                               : !existing.isVirtual() && existing.deviceId == settings.deviceId;
+        if(sameSource && cameras[i]->isInitialized()) {
+            return i;
+        }
+    }
+    
+    auto camera = make_shared<CameraCapture>();
+    if(!camera->setup(settings)) {
+        return -1;
     }
+    
+    cameras.push_back(camera);
+    captureService.add(camera);
+    return cameras.size() - 1;
 }
 
 void ofApp::addCameraTile() {
-    setupCamera();  // Ensure we have a camera
+    if(cameraDevice < 0 || cameraDevice >= cameraDevices.size()) {
+        ofLog() << "Failed to add camera tile - no camera available";
+        return;
+    }
     
-    if(!cameras.empty() && cameras[0].isInitialized()) {
-        // Set desired camera dimensions
-        const int CAMERA_WIDTH = 512;
-        const int CAMERA_HEIGHT = 512;
-        cameras[0].setDesiredFrameRate(30);
-        cameras[0].setup(CAMERA_WIDTH, CAMERA_HEIGHT);
-        
-        // Calculate number of tiles needed
-        int tilesX = ceil(float(CAMERA_WIDTH) / CameraElement::TILE_SIZE);
-        int tilesY = ceil(float(CAMERA_HEIGHT) / CameraElement::TILE_SIZE);
-        
-        // Calculate starting position for this set of tiles
-        float startX = 10;
-        float startY = 10;
+    CameraCapture::Settings settings;
+    settings.deviceId = cameraDevices[cameraDevice].id;
+    settings.width = cameraWidth;
+    settings.height = cameraHeight;
+    settings.frameRate = cameraFrameRate;
+    
+    int cameraIndex = openCamera(settings);
+    if(cameraIndex < 0) {
+        ofLog() << "Failed to add camera tile - could not open " << cameraDevices[cameraDevice].deviceName;
+        return;
+    }
+    
+    addCameraTiles(cameraIndex);
+}
+
+void ofApp::addVirtualCamera() {
+    ofFileDialogResult result = ofSystemLoadDialog("Select Video File for Virtual Camera", false, "videos/");
+    if(result.bSuccess) {
+        CameraCapture::Settings settings;
+        settings.videoPath = result.getPath();
         
-        // Create tiles
-        for(int y = 0; y < tilesY; y++) {
-            for(int x = 0; x < tilesX; x++) {
-                CameraElement tile;
-                
-                // Position tile
-                float tileX = startX + x * CameraElement::TILE_SIZE;
-                float tileY = startY + y * CameraElement::TILE_SIZE;
-                tile.setup(tileX, tileY);
-                
-                // Calculate source region for this tile
-                ofRectangle region(
-                    x * CameraElement::TILE_SIZE,
-                    y * CameraElement::TILE_SIZE,
-                    min(CameraElement::TILE_SIZE, CAMERA_WIDTH - x * CameraElement::TILE_SIZE),
-                    min(CameraElement::TILE_SIZE, CAMERA_HEIGHT - y * CameraElement::TILE_SIZE)
-                );
-                
-                tile.setCameraRegion(0, region);  // Use first camera
-                cameraTiles.push_back(tile);
-            }
+        int cameraIndex = openCamera(settings);
+        if(cameraIndex < 0) {
+            ofLog() << "Failed to add virtual camera: " << settings.videoPath;
+            return;
         }
         
-        // Save the current layout
-        saveCurrentLayout();
-        
-        ofLog() << "Added new camera with " << (tilesX * tilesY) << " tiles";
-    } else {
-        ofLog() << "Failed to add camera tile - no camera available";
+        addCameraTiles(cameraIndex);
+    }
+}
+
+void ofApp::addCameraTiles(size_t cameraIndex) {
+    spatialIndexDirty = true;
+    int width = cameras[cameraIndex]->getWidth();
+    int height = cameras[cameraIndex]->getHeight();
+    
+    // Calculate number of tiles needed at the chosen tile size
+    int sliceSize = newTileSize;
+    int tilesX = ceil(float(width) / sliceSize);
+    int tilesY = ceil(float(height) / sliceSize);
+    size_t firstTile = cameraTiles.size();
+    
+    // Calculate starting position for this set of tiles
+    float startX = 10;
+    float startY = 10;
+    
+    // Create tiles
+    for(int y = 0; y < tilesY; y++) {
+        for(int x = 0; x < tilesX; x++) {
+            CameraElement tile;
+            
+            // Position tile
+            float tileX = startX + x * sliceSize;
+            float tileY = startY + y * sliceSize;
+            tile.setup(tileX, tileY);
+            tile.setTileSize(sliceSize);
+            
+            // Calculate source region for this tile
+            ofRectangle region(
+                x * sliceSize,
+                y * sliceSize,
+                min(sliceSize, width - x * sliceSize),
+                min(sliceSize, height - y * sliceSize)
+            );
+            
+            tile.setCameraRegion(cameraIndex, region);
+            cameraTiles.push_back(tile);
+        }
     }
+    
+    history.push(make_unique<AddTilesCommand>(TileKind::CAMERA, firstTile, cameraTiles.size() - firstTile));
+    
+    // Save the current layout
+    saveCurrentLayout();
+    
+    ofLog() << "Added camera " << cameraIndex << " with " << (tilesX * tilesY) << " tiles";
 }
 
 template<typename T>
@@ -1915,12 +2916,17 @@ template void ofApp::loadTileData<ImageElement>(ImageElement& tile, const ofJson
 template void ofApp::loadTileData<CameraElement>(CameraElement& tile, const ofJson& tileData, size_t newIndex);
 
 void ofApp::createNewLayout() {
+    spatialIndexDirty = true;
     // Clear all elements
     tiles.clear();
+    history.clear();
     imageTiles.clear();
+    invalidateStaticLayers();
     cameraTiles.clear();
     videos.clear();
     images.clear();
+    imageAtlas.clear();
+    captureService.clear();
     cameras.clear();
     
     // Generate new layout name
@@ -1929,14 +2935,24 @@ void ofApp::createNewLayout() {
     // Create empty layout file
     ofJson layout;
     layout["settings"] = {
-        {"showGradient", VideoElement::showGradient}
+        {"showGradient", VideoElement::showGradient},
+        {"gradientStrength", VideoElement::gradientStrength},
+        {"dirtyRegionRendering", dirtyRegionRendering},
+        {"loopFrameCache", loopCacheEnabled}
     };
     layout["videoPaths"] = nlohmann::json::array();
     layout["imagePaths"] = nlohmann::json::array();
     layout["videoTiles"] = nlohmann::json::array();
     layout["imageTiles"] = nlohmann::json::array();
+    layout["cameras"] = nlohmann::json::array();
     layout["cameraTiles"] = nlohmann::json::array();
     
+    // The projector outputs stay as they are
+    layout["outputs"] = nlohmann::json::array();
+    for(const auto& window : outputs) {
+        layout["outputs"].push_back(window->getSettings().toJson());
+    }
+    
     // Create layouts directory if it doesn't exist
     ofDirectory dir("layouts");
     if(!dir.exists()) {
@@ -1963,6 +2979,10 @@ void ofApp::createNewLayout() {
 
 void ofApp::setVideoPlaybackMode(size_t videoIndex, APlaybackMode mode, AOscInputType oscType) {
     if(videoIndex < videoPlaybackSettings.size()) {
+        const auto& previous = videoPlaybackSettings[videoIndex];
+        history.push(make_unique<PlaybackSettingsCommand>(videoIndex,
+            static_cast<int>(std::get<0>(previous)), static_cast<int>(std::get<1>(previous)),
+            static_cast<int>(mode), static_cast<int>(oscType)));
         videoPlaybackSettings[videoIndex] = std::make_tuple(mode, oscType);
         saveCurrentLayout();  // Save changes to current layout
     }
@@ -2024,7 +3044,7 @@ void ofApp::drawVideoPreview() {
     
     const auto& tile = tiles[selectedTile];
     if(tile.videoIndex < videos.size()) {
-        ofVideoPlayer& video = videos[tile.videoIndex];
+        VideoSource& video = videos[tile.videoIndex];
         if(video.isLoaded()) {
             // Draw video preview
             ofPushStyle();
@@ -2063,8 +3083,13 @@ void ofApp::onOscInputChanged(int& value) {
 }
 
 void ofApp::alignTilesToGrid() {
-    // Calculate grid cell size (tile size + spacing)
-    const int cellSize = VideoElement::TILE_SIZE + GRID_SPACING;
+    // Grid cell size: the largest tile plus spacing, so tiles of mixed sizes never overlap
+    float largestTile = 0;
+    for(const auto& tile : tiles) largestTile = max(largestTile, tile.getTileSize());
+    for(const auto& tile : imageTiles) largestTile = max(largestTile, tile.getTileSize());
+    for(const auto& tile : cameraTiles) largestTile = max(largestTile, tile.getTileSize());
+    if(largestTile <= 0) return;
+    const float cellSize = largestTile + GRID_SPACING;
     
     // Calculate grid offset to center it
     float gridWidth = GRID_COLS * cellSize - GRID_SPACING;  // Subtract last spacing
@@ -2095,10 +3120,12 @@ void ofApp::alignTilesToGrid() {
     
     // Record moves for undo
     vector<int> movedTiles;
+    vector<glm::vec2> offsets;
     
     // Align video tiles
     for(size_t i = 0; i < tiles.size(); i++) {
         ofPoint newPos = snapToGrid(tiles[i].x, tiles[i].y);
+        offsets.emplace_back(newPos.x - tiles[i].x, newPos.y - tiles[i].y);
         tiles[i].x = newPos.x;
         tiles[i].y = newPos.y;
         movedTiles.push_back(i);
@@ -2107,14 +3134,18 @@ void ofApp::alignTilesToGrid() {
     // Align image tiles
     for(size_t i = 0; i < imageTiles.size(); i++) {
         ofPoint newPos = snapToGrid(imageTiles[i].x, imageTiles[i].y);
+        offsets.emplace_back(newPos.x - imageTiles[i].x, newPos.y - imageTiles[i].y);
         imageTiles[i].x = newPos.x;
         imageTiles[i].y = newPos.y;
         movedTiles.push_back(i + tiles.size());
     }
+    invalidateStaticLayers();
+    spatialIndexDirty = true;
     
     // Align camera tiles
     for(size_t i = 0; i < cameraTiles.size(); i++) {
         ofPoint newPos = snapToGrid(cameraTiles[i].x, cameraTiles[i].y);
+        offsets.emplace_back(newPos.x - cameraTiles[i].x, newPos.y - cameraTiles[i].y);
         cameraTiles[i].x = newPos.x;
         cameraTiles[i].y = newPos.y;
         movedTiles.push_back(i + tiles.size() + imageTiles.size());
@@ -2122,7 +3153,7 @@ void ofApp::alignTilesToGrid() {
     
     // Record the move for undo
     if(!movedTiles.empty()) {
-        recordTileMove(movedTiles, true);
+        history.push(make_unique<MoveTilesCommand>(movedTiles, offsets));
         saveCurrentLayout();
     }
 }
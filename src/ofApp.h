@@ -8,6 +8,22 @@
 #include "ofxOpenCv.h"
 #include "ImageElement.h"
 #include "CameraElement.h"
+#include "CameraCapture.h"
+#include "CaptureService.h"
+#include "ColorRemap.h"
+#include "TileRenderer.h"
+#include "StaticLayerCache.h"
+#include "ImageAtlas.h"
+#include "OutputWindow.h"
+#include "ChangeTracker.h"
+#include "SpatialIndex.h"
+#include "SelectionSet.h"
+#include "EditHistory.h"
+#include "Profiler.h"
+#include "SwatchExtractor.h"
+#include "OfflineRenderer.h"
+#include "PlaybackSync.h"
+#include "ResourceTracker.h"
 
 enum class APlaybackMode {
     LOOP,           // Default looping playback
@@ -25,6 +41,7 @@ public:
 	void setup();
 	void update();
 	void draw();
+	void exit();
 	
 	// Standard OF events
 	void keyPressed(int key);
@@ -39,12 +56,51 @@ public:
 	void dragEvent(ofDragInfo dragInfo);
 	void gotMessage(ofMessage msg);
 	
+	// Command line options, set before ofRunApp()
+	OfflineRenderer::Settings launchSettings;
+	
+	// Offline rendering: layout time comes from the render clock
+	OfflineRenderer offline;
+	vector<float> videoTimes;
+	bool renderFailed = false;    // a video never reached its frame
+	void setupOfflineRender();
+	void drawFrame();
+	float getTime() const;
+	float getPlaybackSpeed(size_t videoIndex) const;
+	
 	// Media elements
 	vector<VideoElement> tiles;
 	vector<ImageElement> imageTiles;
-	vector<ofVideoPlayer> videos;
+	vector<VideoSource> videos;
 	vector<tuple<APlaybackMode, AOscInputType>> videoPlaybackSettings;
-	vector<ofImage> images;
+	vector<TiledImage> images;
+	TileRenderer tileRenderer;
+	StaticLayerCache staticLayer;    // image tiles, rebuilt only on edits
+	ImageAtlas imageAtlas;           // image tile regions, packed when the static layer is rebuilt
+	ChangeTracker changeTracker;     // last composited frame and what changed since
+	ResourceTracker resources;       // memory per source, tile and pool, refreshed while shown
+	float lastResourceUpdate = -1;
+	static constexpr float RESOURCE_UPDATE_INTERVAL = 2;    // seconds
+	void updateResources();
+	void writeResourceStats();
+	bool dirtyRegionRendering = true;
+	bool loopCacheEnabled = true;    // looping sources play from LoopFrameCache
+	void drawTiles(int output, const StaticLayerCache& layer, const ofRectangle& clip);
+	void renderStaticLayer(StaticLayerCache& layer, int output);
+	void invalidateStaticLayers();
+	void markChangedSources();
+	
+	// Projector outputs beyond the main window, which is output 0
+	shared_ptr<ofAppBaseWindow> mainWindow;
+	vector<unique_ptr<OutputWindow>> outputs;
+	int shownOutput = 0;             // output whose tiles the main window drew last
+	size_t getNumOutputs() const { return outputs.size() + 1; }
+	int getMainOutput() const;
+	int getTileOutput(int index) const;
+	void openOutputs(const vector<OutputWindow::Settings>& settings);
+	void addOutput();
+	void drawOutput(int output);
+	void updateOutputSliders();
 	
 	// Media loading functions
 	void loadVideoAsTiles(const string& path);
@@ -59,31 +115,47 @@ public:
 	float adjustmentSpeed;
 	bool isDragging;
 	ofPoint dragStartPos;
-	ofPoint tileStartPos;
-	vector<int> selectedTiles;
+	SelectionSet selectedTiles;
 	bool isGroupSelected;
 	
 	void deleteTile(int index);
 	int findTileUnderMouse(int x, int y);
+	void selectTilesInRect(const ofRectangle& rect);
+	void drawSelectionOutlines();
+	ofMesh selectionOutlines;
+	
+	// Spatial index over tile screen rectangles per output, keyed by global tile index
+	vector<SpatialIndex> spatialIndices;
+	bool spatialIndexDirty = true;
+	vector<int> visibleTiles;
+	ofRectangle getTileRect(int index) const;
+	void updateSpatialIndex();
+	void updateTileBounds(int index);
+	
+	bool isMarqueeSelecting = false;
+	ofRectangle marqueeRect;
 	void selectTilesFromSameSource(int tileIndex);
 	void moveSelectedTiles(float dx, float dy);
 	
+	// Corner warp editing: 1-4 pick a corner for w/a/s/d to move, 0 goes back to moving tiles
+	int activeCorner = -1;
+	vector<int> getEditedTiles() const;
+	void warpSelectedTiles(float dx, float dy);
+	void resetSelectedWarps();
+	void toggleSelectedPerspective();
+	
 	// Undo system
-	struct TileMove {
-		int tileIndex;
-		float oldX, oldY;
-		float newX, newY;
-	};
-	
-	struct MoveAction {
-		vector<TileMove> moves;
-		bool isGroup;
-	};
-	
-	static const int MAX_UNDO_HISTORY = 20;
-	deque<MoveAction> undoHistory;
-	void recordTileMove(const vector<int>& tileIndices, bool isGroup);
+	EditHistory history;
 	void undo();
+	void redo();
+	BaseElement* getTile(int index);
+	void offsetTile(int index, float dx, float dy);
+	// Without save, the layout is written once no key or mouse button is held
+	void onTilesEdited(bool structural, bool save = true);
+	void savePendingLayout();
+	bool layoutSavePending = false;
+	// With canMerge, repeats of the same edit within the merge window are one undo step
+	void recordPropertyChange(const string& name, const vector<TileState>& before, bool canMerge = false);
 	
 	// GUI Elements
 	ofxPanel gui;
@@ -98,6 +170,11 @@ public:
 	ofxButton addVideoBtn;
 	ofxButton addImageBtn;
 	ofxToggle gradientToggle;
+	ofxToggle gpuRemapToggle;
+	ofxToggle dirtyRegionToggle;
+	ofxButton addOutputBtn;
+	ofxButton resourceStatsBtn;
+	ofxToggle loopCacheToggle;
 	ofxButton newLayoutBtn;
 	
 	// GUI Labels
@@ -107,11 +184,20 @@ public:
 	ofxLabel tileIndexLabel;
 	ofxLabel tileSizeLabel;
 	ofxLabel primaryVideoLabel;
+	ofxLabel cameraLatencyLabel;
+	ofxLabel uploadRegionLabel;
+	ofxLabel memoryLabel;
+	ofxLabel unusedSourcesLabel;
 	
 	// GUI Parameters
 	ofParameter<int> primaryVideoIndex{"Set Primary", -1, -1, 0};
 	ofParameter<int> color1Index;
 	ofParameter<int> color2Index;
+	ofParameter<int> tileOutput;     // output of the selected tiles
+	ofParameter<int> editOutput;     // output the main window shows while editing
+	ofParameter<int> tileSize{"Tile Size", BaseElement::TILE_SIZE, 8, 1024};          // drawn size of the selected tiles
+	ofParameter<int> newTileSize{"New Tile Size", BaseElement::TILE_SIZE, 16, 1024};  // slice size for sources added next
+	ofParameter<float> gradientStrength{"Gradient Strength", 1.0f, 0.0f, 1.0f};
 	ofxToggle colorInputToggle;
 	
 	// GUI Functions
@@ -122,7 +208,21 @@ public:
 	void onColorInputToggled(bool& value);
 	void onColor1Changed(int& index);
 	void onColor2Changed(int& index);
+	void onTileOutputChanged(int& output);
+	void onTileSizeChanged(int& size);
+	void onEditOutputChanged(int& output);
 	void onGradientToggled(bool& value);
+	void onGradientStrengthChanged(float& value);
+	void onGpuRemapToggled(bool& value);
+	void onDirtyRegionToggled(bool& value);
+	void onLoopCacheToggled(bool& value);
+	void verifySelectedTileRemap();
+	// Largest channel difference between the shader and CPU remap of a tile, -1 if they can't be compared
+	int compareTileRemap(int index, const vector<ofColor>& colors);
+	// --verify-remap: checks every color-input tile once sources have frames, then exits
+	int remapCheckFrames = 0;
+	static const int REMAP_CHECK_WARMUP_FRAMES = 30;
+	void runRemapCheck();
 	
 	// Layout Management
 	vector<string> layoutFiles;
@@ -130,6 +230,7 @@ public:
 	bool showGui;
 	void saveLayout();
 	void loadLayout();
+	void loadLayoutFile(const string& path);
 	void saveCurrentLayout();
 	void createNewLayout();
 	string getLayoutPath(const string& name);
@@ -143,6 +244,9 @@ public:
 	static const int OSC_PORT = 9000;
 	void setupOsc();
 	void updateOsc();
+	void applyOscMessage(const string& address, float value);
+	ofstream oscRecording;           // --record-osc, replayed by offline renders
+	PlaybackSync playbackSync;       // --sync, loop playheads shared between nodes
 
 	float yawValue;
 	float pitchValue;
@@ -164,12 +268,25 @@ public:
 	
 	// Add new member variables
 	vector<CameraElement> cameraTiles;
-	vector<ofVideoGrabber> cameras;
+	vector<shared_ptr<CameraCapture>> cameras;
+	CaptureService captureService;
 	
 	// Add new function declarations
 	void setupCamera();
 	void addCameraTile();
+	void addVirtualCamera();
+	int openCamera(const CameraCapture::Settings& settings);
+	void addCameraTiles(size_t cameraIndex);
+	void refreshCameraDevices();
+	void onCameraDeviceChanged(int& index);
 	ofxButton addCameraBtn;
+	ofxButton addVirtualCameraBtn;
+	ofxLabel cameraDeviceLabel;
+	vector<ofVideoDevice> cameraDevices;
+	ofParameter<int> cameraDevice{"Camera Device", 0, 0, 0};
+	ofParameter<int> cameraWidth{"Camera Width", 640, 160, 1920};
+	ofParameter<int> cameraHeight{"Camera Height", 480, 120, 1080};
+	ofParameter<int> cameraFrameRate{"Camera FPS", 30, 1, 60};
 	
 
 	float lastSwatchUpdate;